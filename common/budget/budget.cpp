@@ -0,0 +1,112 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "budget.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Bytes a transfer takes in a queue, the paths and a rough
+ * overhead of the node or closure holding it
+ */
+qint64 Budget::costOf(const models::Transfer &transfer) {
+  auto paths = transfer.getFrom().size() + transfer.getTo().size();
+  return static_cast<qint64>(sizeof(models::Transfer)) + paths * sizeof(QChar) + 64;
+}
+
+/**
+ * @brief Set the budget of all queues in bytes
+ */
+void Budget::setBudget(qint64 bytes) {
+  budget = bytes;
+}
+
+/**
+ * @brief Get the budget of all queues in bytes
+ */
+qint64 Budget::getBudget() const {
+  return budget;
+}
+
+/**
+ * @brief Account an item that has to be taken, an item already in
+ * the pipeline is never dropped so it may go over the bound
+ */
+void Budget::acquire(Queue queue, qint64 bytes) {
+  auto &counter = counters[static_cast<size_t>(queue)];
+  counter.items++;
+  counter.bytes += bytes;
+  total += bytes;
+}
+
+/**
+ * @brief Account an item if the queue has room
+ */
+bool Budget::tryAcquire(Queue queue, qint64 bytes) {
+  if (this->isFull(queue)) {
+    return false;
+  }
+
+  this->acquire(queue, bytes);
+  return true;
+}
+
+/**
+ * @brief Release an item
+ */
+void Budget::release(Queue queue, qint64 bytes) {
+  auto &counter = counters[static_cast<size_t>(queue)];
+  counter.items--;
+  counter.bytes -= bytes;
+  total -= bytes;
+}
+
+/**
+ * @brief Items in the queue
+ */
+qint64 Budget::items(Queue queue) const {
+  return counters[static_cast<size_t>(queue)].items;
+}
+
+/**
+ * @brief Items the queue still takes, none once the budget is spent
+ */
+qint64 Budget::room(Queue queue) const {
+  auto index = static_cast<size_t>(queue);
+
+  if (total >= budget) {
+    return 0;
+  }
+
+  return std::max<qint64>(limits[index] - counters[index].items, 0);
+}
+
+/**
+ * @brief is the queue or the budget full
+ */
+bool Budget::isFull(Queue queue) const {
+  return this->room(queue) == 0;
+}
+
+/**
+ * @brief Occupancy of the queues
+ */
+QList<Budget::Occupancy> Budget::getOccupancy() const {
+  QList<Occupancy> occupancy;
+
+  for (size_t i = 0; i < queues; i++) {
+    occupancy.append(Occupancy{names[i], counters[i].items, counters[i].bytes, limits[i]});
+  }
+
+  return occupancy;
+}
+
+/**
+ * @brief Instance of the budget
+ */
+Budget &Budget::instance() {
+  static Budget instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,134 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "models/transfer/transfer.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Memory budget of the queues between the stages, every queue has
+ * a bound of its own and all of them share one budget of bytes, a stage
+ * that finds the queue in front of it full holds its work back so the
+ * pressure travels up to the watcher which stops polling
+ */
+class Budget {
+ private:
+  Q_DISABLE_COPY_MOVE(Budget)
+
+ public:
+  /**
+   * @brief Queues between the stages
+   */
+  enum class Queue {
+    WATCH,  // watcher to worker, waiting for the writer
+    WORK,   // worker to copier, waiting for the lock or a retry
+    COPY,   // copier, waiting for a slot of the lane
+    EVENT,  // copier to controller, waiting for the ui
+  };
+
+  /**
+   * @brief Occupancy of a queue
+   */
+  struct Occupancy {
+    QString name;
+    qint64 items;
+    qint64 bytes;
+    qint64 limit;
+  };
+
+ private:
+  // counters of a queue
+  struct Counter {
+    std::atomic<qint64> items = 0;
+    std::atomic<qint64> bytes = 0;
+  };
+
+ private:
+  static inline const size_t queues = 4;
+  static inline const std::array<qint64, queues> limits = {65536, 65536, 4096, 16384};
+  static inline const std::array<const char *, queues> names = {"watch", "work", "copy", "event"};
+
+ private:
+  std::array<Counter, queues> counters;
+  std::atomic<qint64> total  = 0;
+  std::atomic<qint64> budget = 64 << 20;
+
+ private:
+  /**
+   * @brief Construct a new Budget object
+   */
+  Budget() = default;
+
+ public:
+  /**
+   * @brief Destroy the Budget object
+   */
+  ~Budget() = default;
+
+  /**
+   * @brief Bytes a transfer takes in a queue
+   */
+  static qint64 costOf(const models::Transfer &transfer);
+
+  /**
+   * @brief Set the budget of all queues in bytes
+   */
+  void setBudget(qint64 bytes);
+
+  /**
+   * @brief Get the budget of all queues in bytes
+   */
+  qint64 getBudget() const;
+
+  /**
+   * @brief Account an item that has to be taken
+   */
+  void acquire(Queue queue, qint64 bytes);
+
+  /**
+   * @brief Account an item if the queue has room
+   */
+  bool tryAcquire(Queue queue, qint64 bytes);
+
+  /**
+   * @brief Release an item
+   */
+  void release(Queue queue, qint64 bytes);
+
+  /**
+   * @brief Items in the queue
+   */
+  qint64 items(Queue queue) const;
+
+  /**
+   * @brief Items the queue still takes
+   */
+  qint64 room(Queue queue) const;
+
+  /**
+   * @brief is the queue or the budget full
+   */
+  bool isFull(Queue queue) const;
+
+  /**
+   * @brief Occupancy of the queues
+   */
+  QList<Occupancy> getOccupancy() const;
+
+  /**
+   * @brief Instance of the budget
+   */
+  static Budget &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
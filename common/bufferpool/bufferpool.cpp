@@ -0,0 +1,150 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "bufferpool.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Construct a new Buffer object
+ */
+BufferPool::Buffer::Buffer(BufferPool *pool, char *bytes) : pool(pool), bytes(bytes) {
+  // Do nothing
+}
+
+/**
+ * @brief Move constructor
+ */
+BufferPool::Buffer::Buffer(Buffer &&other)
+    : pool(std::exchange(other.pool, nullptr)), bytes(std::exchange(other.bytes, nullptr)) {
+  // Do nothing
+}
+
+/**
+ * @brief Move assignment
+ */
+BufferPool::Buffer &BufferPool::Buffer::operator=(Buffer &&other) {
+  if (this != &other) {
+    if (pool) pool->release(bytes);
+    pool  = std::exchange(other.pool, nullptr);
+    bytes = std::exchange(other.bytes, nullptr);
+  }
+
+  return *this;
+}
+
+/**
+ * @brief Return the buffer to the pool
+ */
+BufferPool::Buffer::~Buffer() {
+  if (pool) pool->release(bytes);
+}
+
+/**
+ * @brief Data of the buffer
+ */
+char *BufferPool::Buffer::data() const {
+  return bytes;
+}
+
+/**
+ * @brief Size of the buffer
+ */
+qint64 BufferPool::Buffer::size() const {
+  return pool ? pool->bufferSize : 0;
+}
+
+/**
+ * @brief Return the buffer to the pool, only capacity
+ * buffers are kept idle the rest are freed
+ */
+void BufferPool::release(char *bytes) {
+  QMutexLocker locker(&mutex);
+
+  if (idle.size() < capacity) {
+    return idle.append(bytes);
+  }
+
+  locker.unlock();
+
+#ifdef _WIN32
+  _aligned_free(bytes);
+#else
+  std::free(bytes);
+#endif
+}
+
+/**
+ * @brief Construct a new Buffer Pool object
+ */
+BufferPool::BufferPool(qint64 bufferSize, qint64 alignment, int capacity)
+    : bufferSize(bufferSize), alignment(alignment), capacity(capacity) {
+  // Do nothing
+}
+
+/**
+ * @brief Destroy the Buffer Pool object
+ */
+BufferPool::~BufferPool() {
+  for (auto bytes : idle) {
+#ifdef _WIN32
+    _aligned_free(bytes);
+#else
+    std::free(bytes);
+#endif
+  }
+}
+
+/**
+ * @brief Lease a buffer from the pool
+ */
+BufferPool::Buffer BufferPool::acquire() {
+  QMutexLocker locker(&mutex);
+
+  if (!idle.isEmpty()) {
+    return Buffer(this, idle.takeLast());
+  }
+
+  locker.unlock();
+
+  void *bytes = nullptr;
+
+#ifdef _WIN32
+  bytes = _aligned_malloc(bufferSize, alignment);
+#else
+  if (posix_memalign(&bytes, alignment, bufferSize) != 0) {
+    bytes = nullptr;
+  }
+#endif
+
+  if (bytes == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return Buffer(this, static_cast<char *>(bytes));
+}
+
+/**
+ * @brief Size of the buffers
+ */
+qint64 BufferPool::getBufferSize() const {
+  return bufferSize;
+}
+
+/**
+ * @brief Alignment of the buffers
+ */
+qint64 BufferPool::getAlignment() const {
+  return alignment;
+}
+
+/**
+ * @brief Instance of the default pool, one MiB buffers aligned
+ * to the largest common logical block size
+ */
+BufferPool &BufferPool::instance() {
+  static BufferPool instance(1 << 20, 4096, 16);
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,123 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Pool of aligned buffers, buffers are suitable for unbuffered
+ * I/O and are reused across copies instead of being reallocated
+ */
+class BufferPool {
+ public:
+
+  /**
+   * @brief Buffer leased from the pool, returned on destruction
+   */
+  class Buffer {
+   private:
+    BufferPool *pool = nullptr;
+    char *bytes      = nullptr;
+
+   public:
+
+    /**
+     * @brief Construct an empty Buffer object
+     */
+    Buffer() = default;
+
+    /**
+     * @brief Construct a new Buffer object
+     */
+    Buffer(BufferPool *pool, char *bytes);
+
+    /**
+     * @brief Move constructor
+     */
+    Buffer(Buffer &&other);
+
+    /**
+     * @brief Move assignment
+     */
+    Buffer &operator=(Buffer &&other);
+
+    /**
+     * @brief Return the buffer to the pool
+     */
+    ~Buffer();
+
+    /**
+     * @brief Data of the buffer
+     */
+    char *data() const;
+
+    /**
+     * @brief Size of the buffer
+     */
+    qint64 size() const;
+  };
+
+ private:
+  Q_DISABLE_COPY_MOVE(BufferPool)
+
+ private:
+  const qint64 bufferSize;
+  const qint64 alignment;
+  const int capacity;
+  QList<char *> idle;
+  QMutex mutex;
+
+ private:
+
+  /**
+   * @brief Return the buffer to the pool
+   */
+  void release(char *bytes);
+
+ public:
+
+  /**
+   * @brief Construct a new Buffer Pool object
+   */
+  BufferPool(qint64 bufferSize, qint64 alignment, int capacity);
+
+  /**
+   * @brief Destroy the Buffer Pool object
+   */
+  ~BufferPool();
+
+  /**
+   * @brief Lease a buffer from the pool
+   */
+  Buffer acquire();
+
+  /**
+   * @brief Size of the buffers
+   */
+  qint64 getBufferSize() const;
+
+  /**
+   * @brief Alignment of the buffers
+   */
+  qint64 getAlignment() const;
+
+  /**
+   * @brief Instance of the default pool
+   */
+  static BufferPool &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,239 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "checkpoint.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Equality operator
+ */
+bool Checkpoint::Identity::operator==(const Identity &other) const {
+  return size == other.size && mtime == other.mtime && device == other.device && inode == other.inode;
+}
+
+/**
+ * @brief Inequality operator
+ */
+bool Checkpoint::Identity::operator!=(const Identity &other) const {
+  return !(*this == other);
+}
+
+/**
+ * @brief Construct a new Checkpoint object
+ */
+Checkpoint::Checkpoint(const QString &file) : file(file) {
+  // Do nothing
+}
+
+/**
+ * @brief Load the journal, false if missing or corrupt
+ */
+bool Checkpoint::load() {
+  QFile journal(file);
+
+  if (!journal.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  // payload followed by its checksum
+  auto data = journal.readAll();
+
+  if (data.size() < static_cast<qsizetype>(sizeof(quint16))) {
+    return false;
+  }
+
+  auto payload = data.left(data.size() - sizeof(quint16));
+  QDataStream tail(data.right(sizeof(quint16)));
+  quint16 checksum;
+  tail >> checksum;
+
+  // torn or corrupted journal, start over
+  if (checksum != qChecksum(payload)) {
+    return false;
+  }
+
+  QDataStream stream(payload);
+  quint32 fileMagic;
+  quint16 fileVersion;
+  quint32 count;
+
+  stream >> fileMagic >> fileVersion;
+
+  if (fileMagic != magic || fileVersion != version) {
+    return false;
+  }
+
+  Identity id;
+  stream >> id.size >> id.mtime >> id.device >> id.inode >> count;
+
+  QList<Range> list;
+
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+    Range range;
+    stream >> range.first >> range.second;
+    list.append(range);
+  }
+
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  this->identity = id;
+  this->ranges   = list;
+
+  return true;
+}
+
+/**
+ * @brief Load the journal of the part file, false unless both are
+ * there and belong to the given source identity, a part file of an
+ * other version of the source is useless whatever it holds
+ */
+bool Checkpoint::resume(const Identity &identity, const QString &part) {
+  return this->load() && this->identity == identity && QFile::exists(part);
+}
+
+/**
+ * @brief Atomically replace the journal on disk, QSaveFile writes
+ * to a temporary file, syncs it and renames it over the old one
+ */
+bool Checkpoint::save() {
+  QByteArray payload;
+  QDataStream stream(&payload, QIODevice::WriteOnly);
+
+  stream << magic << version;
+  stream << identity.size << identity.mtime << identity.device << identity.inode;
+  stream << static_cast<quint32>(ranges.size());
+
+  for (const auto &range : ranges) {
+    stream << range.first << range.second;
+  }
+
+  QByteArray tail;
+  QDataStream(&tail, QIODevice::WriteOnly) << qChecksum(payload);
+
+  QSaveFile journal(file);
+
+  if (!journal.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  journal.write(payload);
+  journal.write(tail);
+
+  return journal.commit();
+}
+
+/**
+ * @brief Remove the journal from disk
+ */
+void Checkpoint::remove() {
+  QFile::remove(file);
+}
+
+/**
+ * @brief Start over for the given source identity
+ */
+void Checkpoint::reset(const Identity &identity) {
+  this->identity = identity;
+  this->ranges.clear();
+}
+
+/**
+ * @brief Move to a grown version of the source keeping the ranges,
+ * the committed ranges are still valid for a source that was appended
+ */
+void Checkpoint::extend(const Identity &identity) {
+  this->identity = identity;
+}
+
+/**
+ * @brief Get the source identity
+ */
+const Checkpoint::Identity &Checkpoint::getIdentity() const {
+  return identity;
+}
+
+/**
+ * @brief Mark the range as durable, overlapping and adjacent
+ * ranges are merged so the list stays small and sorted
+ */
+void Checkpoint::commit(qint64 begin, qint64 end) {
+  if (begin >= end) {
+    return;
+  }
+
+  QList<Range> merged;
+  Range current = {begin, end};
+  bool inserted = false;
+
+  for (const auto &range : ranges) {
+    if (range.second < current.first) {
+      merged.append(range);
+    } else if (current.second < range.first) {
+      if (!inserted) {
+        merged.append(current);
+        inserted = true;
+      }
+      merged.append(range);
+    } else {
+      current.first  = std::min(current.first, range.first);
+      current.second = std::max(current.second, range.second);
+    }
+  }
+
+  if (!inserted) {
+    merged.append(current);
+  }
+
+  ranges = merged;
+}
+
+/**
+ * @brief Get the committed ranges
+ */
+const QList<Checkpoint::Range> &Checkpoint::getRanges() const {
+  return ranges;
+}
+
+/**
+ * @brief Get the ranges that are still to be copied
+ */
+QList<Checkpoint::Range> Checkpoint::missing(qint64 size) const {
+  QList<Range> gaps;
+  qint64 cursor = 0;
+
+  for (const auto &range : ranges) {
+    if (range.first >= size) {
+      break;
+    }
+
+    if (cursor < range.first) {
+      gaps.append({cursor, range.first});
+    }
+
+    cursor = std::max(cursor, range.second);
+  }
+
+  if (cursor < size) {
+    gaps.append({cursor, size});
+  }
+
+  return gaps;
+}
+
+/**
+ * @brief Total number of committed bytes
+ */
+qint64 Checkpoint::committed() const {
+  qint64 total = 0;
+
+  for (const auto &range : ranges) {
+    total += range.second - range.first;
+  }
+
+  return total;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
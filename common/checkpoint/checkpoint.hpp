@@ -0,0 +1,129 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QList>
+#include <QPair>
+#include <QSaveFile>
+#include <QString>
+
+#include <algorithm>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Crash safe checkpoint journal of a staged copy, it records
+ * the identity of the source and the byte ranges that are durable
+ * in the part file so an interrupted copy can be resumed
+ */
+class Checkpoint {
+ public:
+
+  /**
+   * @brief Identity of the source file the part file belongs to
+   */
+  struct Identity {
+    qint64 size    = -1;
+    qint64 mtime   = 0;   // nanoseconds since epoch
+    quint64 device = 0;
+    quint64 inode  = 0;
+
+    /**
+     * @brief Equality operator
+     */
+    bool operator==(const Identity &other) const;
+
+    /**
+     * @brief Inequality operator
+     */
+    bool operator!=(const Identity &other) const;
+  };
+
+  /**
+   * @brief Half open byte range [first, second)
+   */
+  using Range = QPair<qint64, qint64>;
+
+ private:
+  static inline const quint32 magic   = 0x50444350;  // PDCP
+  static inline const quint16 version = 1;
+
+ private:
+  QString file;
+  Identity identity;
+  QList<Range> ranges;
+
+ public:
+
+  /**
+   * @brief Construct a new Checkpoint object
+   */
+  Checkpoint(const QString &file);
+
+  /**
+   * @brief Destroy the Checkpoint object
+   */
+  ~Checkpoint() = default;
+
+  /**
+   * @brief Load the journal, false if missing or corrupt
+   */
+  bool load();
+
+  /**
+   * @brief Load the journal of the part file, false unless both
+   * are there and belong to the given source identity
+   */
+  bool resume(const Identity &identity, const QString &part);
+
+  /**
+   * @brief Atomically replace the journal on disk
+   */
+  bool save();
+
+  /**
+   * @brief Remove the journal from disk
+   */
+  void remove();
+
+  /**
+   * @brief Start over for the given source identity
+   */
+  void reset(const Identity &identity);
+
+  /**
+   * @brief Move to a grown version of the source keeping the ranges
+   */
+  void extend(const Identity &identity);
+
+  /**
+   * @brief Get the source identity
+   */
+  const Identity &getIdentity() const;
+
+  /**
+   * @brief Mark the range as durable
+   */
+  void commit(qint64 begin, qint64 end);
+
+  /**
+   * @brief Get the committed ranges
+   */
+  const QList<Range> &getRanges() const;
+
+  /**
+   * @brief Get the ranges that are still to be copied
+   */
+  QList<Range> missing(qint64 size) const;
+
+  /**
+   * @brief Total number of committed bytes
+   */
+  qint64 committed() const;
+};
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "checksum.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Construct a new Checksum object
+ */
+Checksum::Checksum() : state(XXH3_createState()) {
+  this->reset();
+}
+
+/**
+ * @brief Destroy the Checksum object
+ */
+Checksum::~Checksum() {
+  XXH3_freeState(state);
+}
+
+/**
+ * @brief Start a new checksum
+ */
+void Checksum::reset() {
+  XXH3_64bits_reset(state);
+}
+
+/**
+ * @brief Feed the bytes to the checksum
+ */
+void Checksum::update(const char *data, qint64 length) {
+  XXH3_64bits_update(state, data, static_cast<size_t>(length));
+}
+
+/**
+ * @brief Checksum of the bytes fed so far
+ */
+quint64 Checksum::digest() const {
+  return XXH3_64bits_digest(state);
+}
+
+/**
+ * @brief Checksum of the whole file
+ */
+std::optional<quint64> Checksum::of(const QString &file) {
+  QFile input(file);
+
+  if (!input.open(QIODevice::ReadOnly)) {
+    return std::nullopt;
+  }
+
+  QByteArray buffer(1 << 20, Qt::Uninitialized);
+  Checksum checksum;
+
+  while (!input.atEnd()) {
+    auto read = input.read(buffer.data(), buffer.size());
+
+    if (read < 0) {
+      return std::nullopt;
+    }
+
+    checksum.update(buffer.constData(), read);
+  }
+
+  return checksum.digest();
+}
+
+/**
+ * @brief Checksum of count blocks spread evenly over the file, it
+ * reads a bounded amount no matter how large the file is
+ */
+std::optional<quint64> Checksum::sample(const QString &file, int count, qint64 block) {
+  QFile input(file);
+
+  if (!input.open(QIODevice::ReadOnly)) {
+    return std::nullopt;
+  }
+
+  auto size   = input.size();
+  auto stride = count > 1 ? std::max<qint64>(size - block, 0) / (count - 1) : 0;
+  QByteArray buffer(block, Qt::Uninitialized);
+  Checksum checksum;
+
+  for (int i = 0; i < count; i++) {
+    if (!input.seek(i * stride)) {
+      return std::nullopt;
+    }
+
+    auto read = input.read(buffer.data(), buffer.size());
+
+    if (read < 0) {
+      return std::nullopt;
+    }
+
+    checksum.update(buffer.constData(), read);
+  }
+
+  return checksum.digest();
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,66 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QFile>
+#include <QString>
+
+#include <algorithm>
+#include <optional>
+
+#include <xxhash.h>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Streaming XXH3 checksum, the copier feeds it the bytes it
+ * already moves so the content hash costs no extra I/O
+ */
+class Checksum {
+ private:
+  Q_DISABLE_COPY_MOVE(Checksum)
+
+ private:
+  XXH3_state_t *state;
+
+ public:
+
+  /**
+   * @brief Construct a new Checksum object
+   */
+  Checksum();
+
+  /**
+   * @brief Destroy the Checksum object
+   */
+  ~Checksum();
+
+  /**
+   * @brief Start a new checksum
+   */
+  void reset();
+
+  /**
+   * @brief Feed the bytes to the checksum
+   */
+  void update(const char *data, qint64 length);
+
+  /**
+   * @brief Checksum of the bytes fed so far
+   */
+  quint64 digest() const;
+
+  /**
+   * @brief Checksum of the whole file
+   */
+  static std::optional<quint64> of(const QString &file);
+
+  /**
+   * @brief Checksum of count blocks spread evenly over the file,
+   * the first block is always the head of the file
+   */
+  static std::optional<quint64> sample(const QString &file, int count, qint64 block);
+};
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -8,3 +8,9 @@
 #ifdef _WIN32
 #include "win/copier.hpp"
 #endif
+
+#ifdef __linux__
+#include "linux/batchcopier.hpp"
+#include "linux/copier.hpp"
+#include "linux/fanoutcopier.hpp"
+#endif
@@ -14,4 +14,12 @@ namespace srilakshmikanthanp::pulldog::common {
  * @param parent
  */
 ICopier::ICopier(QObject *parent): QObject(parent) {}
+
+/**
+ * @brief The source has a newer version than the one being copied,
+ * a copier that can't tell how the source changed just gives up
+ */
+void ICopier::supersede() {
+  this->cancel();
+}
 }  // namespace srilakshmikanthanp::pulldog::common
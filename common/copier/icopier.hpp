@@ -10,6 +10,7 @@
 #include <QLockFile>
 
 #include "common/locker/locker.hpp"
+#include "models/stats/stats.hpp"
 #include "models/transfer/transfer.hpp"
 
 namespace srilakshmikanthanp::pulldog::common {
@@ -41,6 +42,9 @@ class ICopier : public QObject {
  signals:
   void onCopyCanceled(const models::Transfer&);
 
+ signals:
+  void onCopyStats(const models::Transfer&, const models::TransferStats&);
+
  signals:
   void onError(const QString&);
 
@@ -70,5 +74,10 @@ class ICopier : public QObject {
    * @brief is Cancelled
    */
   virtual bool isCancelled() const = 0;
+
+  /**
+   * @brief The source has a newer version than the one being copied
+   */
+  virtual void supersede();
 };
 }  // namespace srilakshmikanthanp::pulldog::common::copier
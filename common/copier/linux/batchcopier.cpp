@@ -0,0 +1,351 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "batchcopier.hpp"
+
+#ifdef __linux__
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Hidden name of the staged file with the suffix
+ */
+QByteArray BatchCopier::stagedName(const models::Transfer &transfer, const char *suffix) {
+  return QFile::encodeName("." + QFileInfo(transfer.getTo()).fileName() + suffix);
+}
+
+/**
+ * @brief Copy the file into an unpublished file relative to the
+ * directory descriptors, returns errno
+ */
+int BatchCopier::stage(Staged &staged) {
+  const auto &transfer = staged.transfer;
+  auto name = QFile::encodeName(QFileInfo(transfer.getFrom()).fileName());
+  auto src  = ::openat(srcDir, name.constData(), O_RDONLY | O_CLOEXEC);
+
+  if (src < 0) {
+    return errno;
+  }
+
+  DEFER([src] { ::close(src); });
+
+  // identity of the source we are about to copy
+  struct stat &before = staged.source;
+
+  if (::fstat(src, &before) != 0) {
+    return errno;
+  }
+
+  // staged in an unnamed file so nobody sees it half written
+  staged.fd        = ::openat(destDir, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+  staged.anonymous = staged.fd >= 0;
+
+  auto part  = stagedName(transfer, partSuffix);
+  auto flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+
+  if (!staged.anonymous && (staged.fd = ::openat(destDir, part.constData(), flags, 0644)) < 0) {
+    return errno;
+  }
+
+  checksum.reset();
+
+  for (qint64 offset = 0; offset < before.st_size;) {
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    auto length = std::min<qint64>(buffer.size(), before.st_size - offset);
+    auto read = ::read(src, buffer.data(), length);
+
+    if (read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (read < 0) {
+      return errno;
+    }
+
+    // source is truncated underneath us
+    if (read == 0) {
+      return ESTALE;
+    }
+
+    // pay for the chunk once it is read, a retried read isn't charged twice
+    staged.stats.throttled += Governor::instance().acquire(transfer.getFrom(), read, &cancelFlag);
+
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    if (auto error = Copier::writeAll(staged.fd, buffer.data(), read, offset)) {
+      return error;
+    }
+
+    checksum.update(buffer.data(), read);
+    staged.stats.bytes += read;
+    offset += read;
+  }
+
+  // the source changed while copying
+  struct stat after;
+
+  if (::fstat(src, &after) != 0) {
+    return errno;
+  }
+
+  auto changed = after.st_size != before.st_size ||
+                 after.st_mtim.tv_sec != before.st_mtim.tv_sec ||
+                 after.st_mtim.tv_nsec != before.st_mtim.tv_nsec;
+
+  if (changed) {
+    return ESTALE;
+  }
+
+  // keep the modification time like CopyFileEx does
+  struct timespec times[2] = {after.st_atim, after.st_mtim};
+  ::futimens(staged.fd, times);
+
+  staged.hash  = checksum.digest();
+  staged.size  = after.st_size;
+  staged.mtime = after.st_mtim.tv_sec * 1000LL + after.st_mtim.tv_nsec / 1000000;
+
+  return 0;
+}
+
+/**
+ * @brief Close and remove the unpublished file
+ */
+void BatchCopier::discard(Staged &staged) {
+  if (staged.fd < 0) {
+    return;
+  }
+
+  ::close(staged.fd);
+  staged.fd = -1;
+
+  if (!staged.anonymous) {
+    ::unlinkat(destDir, stagedName(staged.transfer, partSuffix).constData(), 0);
+  }
+}
+
+/**
+ * @brief has the source been replaced or rewritten since it was staged,
+ * the name in the source directory is compared with the staged identity
+ */
+bool BatchCopier::isSuperseded(const Staged &staged) const {
+  auto name = QFile::encodeName(QFileInfo(staged.transfer.getFrom()).fileName());
+  struct stat path;
+
+  if (::fstatat(srcDir, name.constData(), &path, 0) != 0) {
+    return true;
+  }
+
+  return path.st_dev != staged.source.st_dev ||
+         path.st_ino != staged.source.st_ino ||
+         path.st_size != staged.source.st_size ||
+         path.st_mtim.tv_sec != staged.source.st_mtim.tv_sec ||
+         path.st_mtim.tv_nsec != staged.source.st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Report the stats of the file once it reached its end
+ */
+void BatchCopier::report(Staged &staged) {
+  staged.stats.elapsed = staged.timer.elapsed();
+  staged.stats.mode    = "batch";
+  emit this->onCopyStats(staged.transfer, staged.stats);
+}
+
+/**
+ * @brief Construct a new BatchCopier object
+ */
+BatchCopier::BatchCopier(QList<models::Transfer> transfers, QObject *parent)
+: ICopier(parent), transfers(transfers) {
+  // Do nothing
+}
+
+/**
+ * @brief start, every file gets its own end, failed or canceled
+ * outcome while the progress is reported for the whole batch
+ */
+void BatchCopier::start() {
+  PULLDOG_TRACE_SPAN("BatchCopier::start");
+
+  if (transfers.isEmpty()) {
+    return;
+  }
+
+  // all of the transfers share the directories
+  auto srcPath  = QFileInfo(transfers.first().getFrom()).dir().path();
+  auto destPath = QFileInfo(transfers.first().getTo()).dir().path();
+  QList<Staged> staged;
+
+  // descriptors are closed on every exit
+  DEFER([&] {
+    for (auto &file : staged) {
+      if (file.fd >= 0) ::close(file.fd);
+    }
+
+    for (auto fd : {&srcDir, &destDir}) {
+      if (*fd >= 0) ::close(*fd);
+      *fd = -1;
+    }
+  });
+
+  srcDir  = ::open(QFile::encodeName(srcPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  destDir = ::open(QFile::encodeName(destPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (srcDir < 0 || destDir < 0) {
+    auto error = errno;
+
+    for (const auto &transfer : transfers) {
+      emit this->onCopyFailed(transfer, error);
+    }
+
+    return;
+  }
+
+  buffer = BufferPool::instance().acquire();
+  staged.reserve(transfers.size());
+  progress.setTotal(transfers.size());
+
+  // emit the progress of the batch at a bounded rate
+  const auto advance = [&]() {
+    progress.add(1);
+
+    if (progress.isDue()) {
+      emit this->onBatchProgress(srcPath, progress.getDone(), progress.getTotal());
+    }
+  };
+
+  for (const auto &transfer : transfers) {
+    Staged file{transfer};
+    file.timer.start();
+
+    // every file is started on its own like a single copy
+    emit this->onCopyStart(transfer);
+
+    if (cancelFlag) {
+      emit this->onCopyCanceled(transfer);
+      this->report(file);
+      continue;
+    }
+
+    // if already exists and up to date
+    if (QFileInfo::exists(transfer.getTo()) && Sidecar::isUptoDate(transfer.getFrom(), transfer.getTo())) {
+      emit this->onCopyEnd(transfer);
+      this->report(file);
+      advance();
+      continue;
+    }
+
+    auto error = this->stage(file);
+
+    if (error == ECANCELED) {
+      this->discard(file);
+      emit this->onCopyCanceled(transfer);
+      this->report(file);
+      continue;
+    }
+
+    if (error) {
+      this->discard(file);
+      emit this->onCopyFailed(transfer, error);
+      this->report(file);
+      continue;
+    }
+
+    staged.append(file);
+    advance();
+  }
+
+  // a file with a newer version is given up so the next attempt copies it
+  if (staleFlag.exchange(false)) {
+    for (auto it = staged.begin(); it != staged.end();) {
+      if (!this->isSuperseded(*it)) {
+        ++it;
+        continue;
+      }
+
+      this->discard(*it);
+      emit this->onCopyCanceled(it->transfer);
+      this->report(*it);
+      it = staged.erase(it);
+    }
+  }
+
+  // publish the whole batch in one group commit
+  QList<Committer::Entry> entries;
+  entries.reserve(staged.size());
+
+  for (auto &file : staged) {
+    auto to   = QFile::encodeName(file.transfer.getTo());
+    auto link = QFile::encodeName(destPath) + "/" + stagedName(file.transfer, linkSuffix);
+
+    const auto publish = [this, &file, to, link]() -> int {
+      if (file.anonymous) {
+        return Copier::linkInto(file.fd, to, link);
+      }
+
+      auto part = stagedName(file.transfer, partSuffix);
+      return ::renameat(destDir, part.constData(), AT_FDCWD, to.constData()) == 0 ? 0 : errno;
+    };
+
+    // the old sidecar no longer describes the destination
+    Sidecar::remove(file.transfer.getTo());
+    entries.append({file.fd, destPath, publish});
+  }
+
+  auto results = Committer::instance().commit(entries);
+
+  for (qsizetype i = 0; i < staged.size(); i++) {
+    auto &file = staged[i];
+
+    if (results[i]) {
+      this->discard(file);
+      emit this->onCopyFailed(file.transfer, results[i]);
+      this->report(file);
+      continue;
+    }
+
+    struct stat dest;
+
+    if (::fstat(file.fd, &dest) == 0) {
+      Sidecar::Record record;
+      record.hash      = file.hash;
+      record.srcSize   = file.size;
+      record.srcMtime  = file.mtime;
+      record.destSize  = dest.st_size;
+      record.destMtime = dest.st_mtim.tv_sec * 1000LL + dest.st_mtim.tv_nsec / 1000000;
+      record.srcId     = {file.source.st_dev, file.source.st_ino};
+      Sidecar::save(file.transfer.getTo(), record);
+    }
+
+    emit this->onCopyEnd(file.transfer);
+    this->report(file);
+  }
+}
+
+/**
+ * @brief Cancel the copy
+ */
+void BatchCopier::cancel() {
+  cancelFlag = true;
+}
+
+/**
+ * @brief Is Cancelled
+ */
+bool BatchCopier::isCancelled() const {
+  return cancelFlag;
+}
+
+/**
+ * @brief The source of a file has a newer version, checked before the
+ * batch is published so only the changed files are given up
+ */
+void BatchCopier::supersede() {
+  staleFlag = true;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
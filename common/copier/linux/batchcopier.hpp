@@ -0,0 +1,142 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+#ifdef __linux__  // only linux
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QObject>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+
+#include "common/bufferpool/bufferpool.hpp"
+#include "common/checksum/checksum.hpp"
+#include "common/copier/icopier.hpp"
+#include "common/copier/linux/committer.hpp"
+#include "common/copier/linux/copier.hpp"
+#include "common/governor/governor.hpp"
+#include "common/progress/progress.hpp"
+#include "common/sidecar/sidecar.hpp"
+#include "common/trace/trace.hpp"
+#include "models/stats/stats.hpp"
+#include "models/transfer/transfer.hpp"
+#include "utility/deferred/deferred.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief A Class that copies a group of small files that share the
+ * source and the destination directory in one task, the directories
+ * are opened once, one buffer is reused for every file and all the
+ * files are committed together
+ */
+class BatchCopier : public ICopier {
+ private:
+
+  Q_DISABLE_COPY(BatchCopier)
+
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ signals:
+  void onBatchProgress(const QString &dir, int completed, int total);
+
+ private:
+  static inline const char *partSuffix = ".pulldog-part";
+  static inline const char *linkSuffix = ".pulldog-link";
+
+ private:
+  // a copied file waiting for the commit
+  struct Staged {
+    models::Transfer transfer;
+    int fd         = -1;
+    bool anonymous = false;
+    quint64 hash   = 0;
+    qint64 size    = -1;
+    qint64 mtime   = 0;  // milliseconds since epoch
+    struct stat source = {};  // identity of the copied source
+    models::TransferStats stats;
+    QElapsedTimer timer;
+  };
+
+ private:
+  std::atomic<bool> cancelFlag = false;
+  std::atomic<bool> staleFlag  = false;
+  const QList<models::Transfer> transfers;
+  BufferPool::Buffer buffer;
+  Checksum checksum;
+  Progress progress;
+  int srcDir  = -1;
+  int destDir = -1;
+
+ private:
+  /**
+   * @brief Hidden name of the staged file with the suffix
+   */
+  static QByteArray stagedName(const models::Transfer &transfer, const char *suffix);
+
+  /**
+   * @brief Copy the file into an unpublished file, returns errno
+   */
+  int stage(Staged &staged);
+
+  /**
+   * @brief Close and remove the unpublished file
+   */
+  void discard(Staged &staged);
+
+  /**
+   * @brief has the source been replaced or rewritten since it was staged
+   */
+  bool isSuperseded(const Staged &staged) const;
+
+  /**
+   * @brief Report the stats of the file
+   */
+  void report(Staged &staged);
+
+ public:
+
+  /**
+   * @brief Construct a new BatchCopier object
+   */
+  BatchCopier(QList<models::Transfer> transfers, QObject *parent = nullptr);
+
+  /**
+   * @brief Destroy the BatchCopier object
+   */
+  virtual ~BatchCopier() = default;
+
+  /**
+   * @brief start
+   */
+  void start() override;
+
+  /**
+   * @brief Cancel the copy
+   */
+  void cancel() override;
+
+  /**
+   * @brief is Cancelled
+   */
+  bool isCancelled() const override;
+
+  /**
+   * @brief The source of a file has a newer version
+   */
+  void supersede() override;
+};
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "committer.hpp"
+
+#ifdef __linux__
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Make the batch durable and publish it, a large batch is
+ * flushed with one syncfs per file system instead of fdatasync per file
+ */
+void Committer::process(const QList<Request *> &batch) {
+  if (batch.size() >= syncfsThreshold) {
+    QMap<dev_t, int> devices;
+
+    for (auto request : batch) {
+      struct stat info;
+
+      if (::fstat(request->fd, &info) != 0) {
+        request->result = errno;
+        continue;
+      }
+
+      if (!devices.contains(info.st_dev)) {
+        devices[info.st_dev] = ::syncfs(request->fd) == 0 ? 0 : errno;
+      }
+
+      request->result = devices[info.st_dev];
+    }
+  } else {
+    for (auto request : batch) {
+      if (::fdatasync(request->fd) != 0) {
+        request->result = errno;
+      }
+    }
+  }
+
+  // publish only what is durable
+  QSet<QString> dirs;
+
+  for (auto request : batch) {
+    if (request->result == 0 && (request->result = request->publish()) == 0) {
+      dirs.insert(request->dir);
+    }
+  }
+
+  // make the new names durable
+  for (const auto &dir : dirs) {
+    auto fd = ::open(QFile::encodeName(dir).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd >= 0) {
+      ::fsync(fd);
+      ::close(fd);
+    }
+  }
+}
+
+/**
+ * @brief Make the data of fd durable then run publish
+ */
+int Committer::commit(int fd, const QString &dir, const std::function<int()> &publish) {
+  return this->commit(QList<Entry>{{fd, dir, publish}}).first();
+}
+
+/**
+ * @brief Commit several files at once, there is no timer, the files
+ * that arrive while a leader is flushing simply form the next batch
+ * so a lone file is never delayed
+ */
+QList<int> Committer::commit(const QList<Entry> &entries) {
+  QList<Request> requests;
+  requests.reserve(entries.size());
+
+  for (const auto &entry : entries) {
+    requests.append({entry.fd, entry.dir, entry.publish});
+  }
+
+  // all of our files are committed
+  const auto finished = [&requests]() {
+    return std::all_of(requests.begin(), requests.end(), [](const auto &r) { return r.done; });
+  };
+
+  QMutexLocker locker(&mutex);
+
+  for (auto &request : requests) {
+    pending.append(&request);
+  }
+
+  while (!finished()) {
+    if (leading) {
+      condition.wait(&mutex);
+      continue;
+    }
+
+    // become the leader of whatever is pending
+    leading    = true;
+    auto batch = pending.mid(0, batchLimit);
+    pending.remove(0, batch.size());
+    locker.unlock();
+
+    this->process(batch);
+
+    locker.relock();
+
+    for (auto done : batch) {
+      done->done = true;
+    }
+
+    leading = false;
+    condition.wakeAll();
+  }
+
+  QList<int> results;
+  results.reserve(requests.size());
+
+  for (const auto &request : requests) {
+    results.append(request.result);
+  }
+
+  return results;
+}
+
+/**
+ * @brief Instance of the committer
+ */
+Committer &Committer::instance() {
+  static Committer instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
@@ -0,0 +1,103 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+#ifdef __linux__  // only linux
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Group commit of finished copies, the first copier to arrive
+ * becomes the leader and makes every file that queued up meanwhile
+ * durable, publishes them and syncs their directories once per batch
+ */
+class Committer {
+ private:
+  Q_DISABLE_COPY_MOVE(Committer)
+
+ public:
+  /**
+   * @brief A file to be committed
+   */
+  struct Entry {
+    int fd;
+    QString dir;
+    std::function<int()> publish;
+  };
+
+ private:
+  // a file waiting to be committed
+  struct Request {
+    int fd;
+    QString dir;
+    std::function<int()> publish;
+    int result = 0;
+    bool done  = false;
+  };
+
+ private:
+  static inline const int batchLimit      = 256;
+  static inline const int syncfsThreshold = 32;
+
+ private:
+  QList<Request *> pending;
+  QWaitCondition condition;
+  bool leading = false;
+  QMutex mutex;
+
+ private:
+
+  /**
+   * @brief Construct a new Committer object
+   */
+  Committer() = default;
+
+  /**
+   * @brief Make the batch durable and publish it
+   */
+  void process(const QList<Request *> &batch);
+
+ public:
+
+  /**
+   * @brief Destroy the Committer object
+   */
+  ~Committer() = default;
+
+  /**
+   * @brief Make the data of fd durable then run publish, blocks
+   * until the batch the file joined is committed, returns errno
+   */
+  int commit(int fd, const QString &dir, const std::function<int()> &publish);
+
+  /**
+   * @brief Commit several files at once, blocks until all of them
+   * are committed, returns errno of each entry in order
+   */
+  QList<int> commit(const QList<Entry> &entries);
+
+  /**
+   * @brief Instance of the committer
+   */
+  static Committer &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
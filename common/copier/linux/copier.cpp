@@ -0,0 +1,683 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "copier.hpp"
+
+#ifdef __linux__
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Path of the staged file with the suffix, it is kept
+ * hidden next to the destination so the rename is atomic
+ */
+QString Copier::stagedFile(const char *suffix) const {
+  auto info = QFileInfo(transfer.getTo());
+  return info.dir().filePath("." + info.fileName() + suffix);
+}
+
+/**
+ * @brief Identity of the file from the stat
+ */
+Checkpoint::Identity Copier::identityOf(const struct stat &info) {
+  Checkpoint::Identity identity;
+  identity.size   = info.st_size;
+  identity.mtime  = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+  identity.device = info.st_dev;
+  identity.inode  = info.st_ino;
+  return identity;
+}
+
+/**
+ * @brief Mode for a file of the size, bulk files bypass
+ * the page cache so they don't evict the hot working set
+ */
+Copier::Mode Copier::modeOf(qint64 size) {
+  if (size >= directThreshold) {
+    return Mode::DIRECT;
+  }
+
+  if (size >= streamingThreshold) {
+    return Mode::STREAMING;
+  }
+
+  return Mode::BUFFERED;
+}
+
+/**
+ * @brief Name of the mode
+ */
+QString Copier::nameOf(Mode mode) {
+  switch (mode) {
+  case Mode::DIRECT:
+    return "direct";
+  case Mode::STREAMING:
+    return "streaming";
+  default:
+    return "buffered";
+  }
+}
+
+/**
+ * @brief Write the whole data at the offset, returns errno
+ */
+int Copier::writeAll(int fd, const char *data, qint64 length, qint64 offset) {
+  for (qint64 written = 0; written < length;) {
+    auto result = ::pwrite(fd, data + written, length - written, offset + written);
+
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (result < 0) {
+      return errno;
+    }
+
+    written += result;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Open the O_DIRECT descriptors, not every file system
+ * supports O_DIRECT so fall back to streaming if it fails
+ */
+void Copier::openDirect(const QByteArray &from, const QByteArray &part) {
+  handles.srcDirect  = ::open(from.constData(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+  handles.destDirect = ::open(part.constData(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+
+  if (handles.srcDirect >= 0 && handles.destDirect >= 0) {
+    return;
+  }
+
+  for (auto fd : {&handles.srcDirect, &handles.destDirect}) {
+    if (*fd >= 0) ::close(*fd);
+    *fd = -1;
+  }
+
+  mode = Mode::STREAMING;
+}
+
+/**
+ * @brief Close all descriptors
+ */
+void Copier::closeHandles() {
+  for (auto fd : {&handles.src, &handles.dest, &handles.srcDirect, &handles.destDirect}) {
+    if (*fd >= 0) ::close(*fd);
+    *fd = -1;
+  }
+}
+
+/**
+ * @brief Give the unnamed staged file its final name, linkat can't
+ * replace an existing file so an older version is replaced through
+ * a hidden link and a rename
+ */
+int Copier::linkInto(int fd, const QByteArray &to, const QByteArray &link) {
+  auto proc = QByteArray("/proc/self/fd/") + QByteArray::number(fd);
+
+  if (::linkat(AT_FDCWD, proc.constData(), AT_FDCWD, to.constData(), AT_SYMLINK_FOLLOW) == 0) {
+    return 0;
+  }
+
+  if (errno != EEXIST) {
+    return errno;
+  }
+
+  ::unlink(link.constData());
+
+  if (::linkat(AT_FDCWD, proc.constData(), AT_FDCWD, link.constData(), AT_SYMLINK_FOLLOW) != 0) {
+    return errno;
+  }
+
+  if (::rename(link.constData(), to.constData()) != 0) {
+    auto error = errno;
+    ::unlink(link.constData());
+    return error;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Materialize the destination from an identical local file, a
+ * reflink shares the extents copy on write so both files stay independent,
+ * otherwise a hard link shares the inode which is safe as long as nobody
+ * edits the destination in place since every copy replaces the inode
+ */
+int Copier::cloneFrom(const QString &match, const QByteArray &to, const struct stat &info) {
+  // the destination itself already has the content
+  if (match == transfer.getTo()) {
+    return 0;
+  }
+
+  auto dir    = QFileInfo(transfer.getTo()).dir().path();
+  auto link   = QFile::encodeName(stagedFile(linkSuffix));
+  auto source = ::open(QFile::encodeName(match).constData(), O_RDONLY | O_CLOEXEC);
+
+  if (source < 0) {
+    return errno;
+  }
+
+  DEFER([source] { ::close(source); });
+
+  auto clone = ::open(QFile::encodeName(dir).constData(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+
+  if (clone >= 0) {
+    DEFER([clone] { ::close(clone); });
+
+    if (::ioctl(clone, FICLONE, source) == 0) {
+      struct timespec times[2] = {info.st_atim, info.st_mtim};
+      ::futimens(clone, times);
+
+      return Committer::instance().commit(clone, dir, [&]() { return linkInto(clone, to, link); });
+    }
+  }
+
+  // hard links can't cross file systems
+  const auto publish = [&]() -> int {
+    ::unlink(link.constData());
+
+    if (::link(QFile::encodeName(match).constData(), link.constData()) != 0) {
+      return errno;
+    }
+
+    if (::rename(link.constData(), to.constData()) != 0) {
+      auto error = errno;
+      ::unlink(link.constData());
+      return error;
+    }
+
+    return 0;
+  };
+
+  return Committer::instance().commit(source, dir, publish);
+}
+
+/**
+ * @brief Split the range of the source into data and hole pieces in
+ * file order, a file system without SEEK_DATA reports it all as data
+ */
+QList<Copier::Piece> Copier::extentsOf(qint64 begin, qint64 end) const {
+  QList<Piece> pieces;
+  auto cursor = begin;
+
+  while (cursor < end) {
+    auto data = ::lseek(handles.src, cursor, SEEK_DATA);
+
+    // only a hole is left till the end of the file
+    if (data < 0 && errno == ENXIO) {
+      break;
+    }
+
+    if (data < 0) {
+      pieces.append({{cursor, end}, true});
+      return pieces;
+    }
+
+    if (data > cursor) {
+      pieces.append({{cursor, std::min<qint64>(data, end)}, false});
+    }
+
+    if (data >= end) {
+      return pieces;
+    }
+
+    auto hole = ::lseek(handles.src, data, SEEK_HOLE);
+    hole = hole < 0 ? end : std::min<qint64>(hole, end);
+    pieces.append({{data, hole}, true});
+    cursor = hole;
+  }
+
+  if (cursor < end) {
+    pieces.append({{cursor, end}, false});
+  }
+
+  return pieces;
+}
+
+/**
+ * @brief Account the hole in the range as copied, the destination
+ * already has the full size so the hole is left unallocated and only
+ * the checksum has to see the zeros
+ */
+int Copier::skipHole(Checkpoint &checkpoint, qint64 begin, qint64 end) {
+  static const QByteArray zeros(1 << 20, '\0');
+
+  for (auto cursor = begin; hashing && cursor < end;) {
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    auto length = std::min<qint64>(zeros.size(), end - cursor);
+    checksum.update(zeros.constData(), length);
+    cursor += length;
+  }
+
+  if (journaled) {
+    checkpoint.commit(begin, end);
+  }
+
+  stats.holes += end - begin;
+  progress.add(end - begin);
+  Metrics::instance().count(Metrics::Counter::HOLES, end - begin);
+
+  return 0;
+}
+
+/**
+ * @brief has the source been replaced or rewritten since the copy started,
+ * a source that only grew is not, its new tail is copied at the end
+ */
+bool Copier::isSuperseded() const {
+  struct stat path, open;
+
+  if (::stat(QFile::encodeName(transfer.getFrom()).constData(), &path) != 0 || ::fstat(handles.src, &open) != 0) {
+    return true;
+  }
+
+  // a new file was renamed over the source
+  if (path.st_dev != open.st_dev || path.st_ino != open.st_ino) {
+    return true;
+  }
+
+  // truncated or rewritten in place
+  return open.st_size < identity.size || (open.st_size == identity.size && identityOf(open) != identity);
+}
+
+/**
+ * @brief Copy the range and checkpoint it, returns errno
+ */
+int Copier::copyRange(Checkpoint &checkpoint, qint64 begin, qint64 end) {
+  auto alignment = BufferPool::instance().getAlignment();
+  auto durable   = begin;
+  auto dropped   = begin;
+  auto cursor    = begin;
+
+  // make the bytes written so far durable and record them
+  const auto sync = [&]() {
+    if (journaled && cursor > durable && ::fdatasync(handles.dest) == 0) {
+      checkpoint.commit(durable, cursor);
+      checkpoint.save();
+      durable = cursor;
+    }
+  };
+
+  // checkpoint whatever is written on every exit
+  DEFER(sync);
+
+  while (cursor < end) {
+    // a more urgent copy may pause us here
+    Scheduler::instance().yield(static_cast<ICopier *>(this), progress.getTotal() - progress.getDone());
+
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    // the bytes of a newer version would be mixed with these
+    if (staleFlag.exchange(false) && this->isSuperseded()) {
+      return ECANCELED;
+    }
+
+    auto length = std::min(buffer.size(), end - cursor);
+
+    // O_DIRECT needs aligned offsets, the length is rounded up
+    // and the read stops short at the end of the file
+    auto direct  = mode == Mode::DIRECT && cursor % alignment == 0;
+    auto request = direct ? (length + alignment - 1) / alignment * alignment : length;
+    auto source  = direct ? handles.srcDirect : handles.src;
+    auto read    = ::pread(source, buffer.data(), request, cursor);
+
+    if (read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    // file system refused the unbuffered read
+    if (read < 0 && errno == EINVAL && direct) {
+      mode = Mode::STREAMING;
+      continue;
+    }
+
+    if (read < 0) {
+      return errno;
+    }
+
+    // source is truncated underneath us
+    if (read == 0) {
+      return ESTALE;
+    }
+
+    read = std::min<qint64>(read, length);
+
+    // pay for the chunk once it is read, a retried read isn't charged twice
+    stats.throttled += Governor::instance().acquire(transfer.getFrom(), read, &cancelFlag);
+
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    // aligned head goes unbuffered, the unaligned tail is buffered
+    auto aligned = direct ? read - read % alignment : 0;
+    auto error   = aligned ? writeAll(handles.destDirect, buffer.data(), aligned, cursor) : 0;
+
+    if (error == EINVAL) {
+      mode    = Mode::STREAMING;
+      aligned = 0;
+      error   = 0;
+    }
+
+    if (!error) {
+      error = writeAll(handles.dest, buffer.data() + aligned, read - aligned, cursor + aligned);
+    }
+
+    if (error) {
+      return error;
+    }
+
+    // hash the bytes while they are still hot in the cache
+    if (hashing) {
+      checksum.update(buffer.data(), read);
+    }
+
+    // start write back now and drop what is already on disk
+    if (mode == Mode::STREAMING) {
+      ::sync_file_range(handles.dest, cursor, read, SYNC_FILE_RANGE_WRITE);
+
+      if (cursor - dropped >= dropBehind) {
+        auto flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+        ::sync_file_range(handles.dest, dropped, cursor - dropped, flags);
+        ::posix_fadvise(handles.dest, dropped, cursor - dropped, POSIX_FADV_DONTNEED);
+        dropped = cursor;
+      }
+    }
+
+    cursor += read;
+    stats.bytes += read;
+    progress.add(read);
+
+    if (cursor - durable >= checkpointInterval) {
+      sync();
+    }
+
+    // emit progress at a bounded rate
+    if (progress.isDue()) {
+      emit onCopy(transfer, progress.percent());
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Construct a new Copier object
+ *
+ * @param src
+ * @param dest
+ * @param parent
+ */
+Copier::Copier(models::Transfer transfer, QObject *parent)
+: ICopier(parent), transfer(transfer) {
+  // Do nothing
+}
+
+/**
+ * @brief start
+ */
+void Copier::start() {
+  PULLDOG_TRACE_SPAN_ID("Copier::start", qHash(transfer.getTo()));
+
+  // get the from and to of the transfer
+  auto from = QFile::encodeName(transfer.getFrom());
+  auto to   = QFile::encodeName(transfer.getTo());
+
+  // emit the started signal
+  emit this->onCopyStart(transfer);
+
+  // report the stats on every exit
+  QElapsedTimer timer;
+  timer.start();
+
+  DEFER([&] {
+    stats.elapsed = timer.elapsed();
+    stats.mode    = deduped ? QString("dedup") : nameOf(mode) + (sparse ? "+sparse" : "");
+    emit this->onCopyStats(transfer, stats);
+  });
+
+  // if already exists and up to date
+  if (QFileInfo::exists(transfer.getTo()) && Sidecar::isUptoDate(transfer.getFrom(), transfer.getTo())) {
+    return emit this->onCopyEnd(transfer);
+  }
+
+  // descriptors are closed on every exit
+  DEFER([this] { this->closeHandles(); });
+
+  // open the source
+  if ((handles.src = ::open(from.constData(), O_RDONLY | O_CLOEXEC)) < 0) {
+    return emit this->onCopyFailed(transfer, errno);
+  }
+
+  // identity of the source we are about to copy
+  struct stat info;
+
+  if (::fstat(handles.src, &info) != 0) {
+    return emit this->onCopyFailed(transfer, errno);
+  }
+
+  // an identical file is already on this side
+  if (auto match = Dedup::instance().find(transfer.getFrom())) {
+    Sidecar::remove(transfer.getTo());
+
+    if ((deduped = this->cloneFrom(match->path, to, info) == 0)) {
+      auto dest = QFileInfo(transfer.getTo());
+      Sidecar::Record record;
+      record.hash      = match->hash;
+      record.srcSize   = info.st_size;
+      record.srcMtime  = info.st_mtim.tv_sec * 1000LL + info.st_mtim.tv_nsec / 1000000;
+      record.destSize  = dest.size();
+      record.destMtime = dest.lastModified().toMSecsSinceEpoch();
+      record.srcId     = {info.st_dev, info.st_ino};
+      Sidecar::save(transfer.getTo(), record);
+      Dedup::instance().insert(transfer.getTo(), match->hash);
+      return emit this->onCopyEnd(transfer);
+    }
+  }
+
+  identity      = identityOf(info);
+  auto part     = QFile::encodeName(stagedFile(partSuffix));
+  auto dir      = QFileInfo(transfer.getTo()).dir().path();
+  auto resume   = false;
+  Checkpoint checkpoint(stagedFile(journalSuffix));
+
+  // pick the mode by the size of the file, small files are
+  // cheaper to copy again than to journal
+  mode      = modeOf(identity.size);
+  journaled = mode != Mode::BUFFERED;
+
+  // small files are staged in an unnamed file so nobody sees them half written
+  if (!journaled) {
+    handles.dest = ::open(QFile::encodeName(dir).constData(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+    anonymous    = handles.dest >= 0;
+  }
+
+  // resume only if the part file belongs to the same version of source
+  if (journaled) {
+    resume = checkpoint.resume(identity, QFile::decodeName(part));
+  }
+
+  if (!resume) {
+    checkpoint.reset(identity);
+  }
+
+  // a fresh copy is one sequential pass so it can be hashed inline
+  hashing = !resume;
+
+  // open the part file, truncate it if it can't be resumed
+  auto flags = O_WRONLY | O_CREAT | O_CLOEXEC | (resume ? 0 : O_TRUNC);
+
+  if (!anonymous && (handles.dest = ::open(part.constData(), flags, 0644)) < 0) {
+    return emit this->onCopyFailed(transfer, errno);
+  }
+
+  // record the identity before any data is written
+  if (journaled && !resume && !checkpoint.save()) {
+    return emit this->onCopyFailed(transfer, EIO);
+  }
+
+  if (mode == Mode::DIRECT) {
+    this->openDirect(from, part);
+  }
+
+  if (mode == Mode::STREAMING) {
+    ::posix_fadvise(handles.src, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+
+  // bytes already durable in the part file
+  buffer = BufferPool::instance().acquire();
+  progress.setTotal(identity.size);
+  progress.setDone(checkpoint.committed());
+  int error = 0;
+
+  // fewer blocks than the size means the source has holes
+  sparse = static_cast<qint64>(info.st_blocks) * 512 < identity.size;
+
+  // holes stay unallocated once the destination has its full size
+  if (sparse && ::ftruncate(handles.dest, identity.size) != 0) {
+    sparse = false;
+  }
+
+  if (sparse) {
+    Metrics::instance().count(Metrics::Counter::SPARSE);
+  }
+
+  // copy the ranges that are not yet committed, only data extents
+  // of a sparse source go over the wire
+  for (const auto &range : checkpoint.missing(identity.size)) {
+    auto pieces = sparse ? this->extentsOf(range.first, range.second) : QList<Piece>{{range, true}};
+
+    for (const auto &[piece, data] : pieces) {
+      if (data) {
+        error = this->copyRange(checkpoint, piece.first, piece.second);
+      } else {
+        error = this->skipHole(checkpoint, piece.first, piece.second);
+      }
+
+      if (error) {
+        break;
+      }
+    }
+
+    if (error) {
+      break;
+    }
+  }
+
+  // a source that only grew is copied on in place, bounded so
+  // a file that never stops growing isn't chased forever
+  for (int extended = 0; !error && extended < maxExtensions; extended++) {
+    if (::fstat(handles.src, &info) != 0 || identityOf(info) == identity || this->isSuperseded()) {
+      break;
+    }
+
+    auto begin = identity.size;
+    identity   = identityOf(info);
+
+    if (journaled) {
+      checkpoint.extend(identity);
+      checkpoint.save();
+    }
+
+    progress.setTotal(identity.size);
+    error = this->copyRange(checkpoint, begin, identity.size);
+  }
+
+  // if canceled, the part file is kept for later resume
+  if (error == ECANCELED) {
+    return emit this->onCopyCanceled(transfer);
+  }
+
+  if (error) {
+    return emit this->onCopyFailed(transfer, error);
+  }
+
+  // the source changed while copying, the part file is useless
+  if (::fstat(handles.src, &info) != 0 || identityOf(info) != identity) {
+    checkpoint.remove();
+    QFile::remove(QFile::decodeName(part));
+    return emit this->onCopyFailed(transfer, ESTALE);
+  }
+
+  // keep the modification time like CopyFileEx does
+  struct timespec times[2] = {info.st_atim, info.st_mtim};
+  ::futimens(handles.dest, times);
+
+  // publish the file into place once it is durable
+  const auto publish = [&]() -> int {
+    if (anonymous) {
+      return linkInto(handles.dest, to, QFile::encodeName(stagedFile(linkSuffix)));
+    }
+
+    return ::rename(part.constData(), to.constData()) == 0 ? 0 : errno;
+  };
+
+  // the old sidecar no longer describes the destination
+  Sidecar::remove(transfer.getTo());
+
+  if ((error = Committer::instance().commit(handles.dest, dir, publish))) {
+    return emit this->onCopyFailed(transfer, error);
+  }
+
+  // a resumed copy is hashed from the local destination instead
+  auto hash = hashing ? std::optional<quint64>(checksum.digest()) : Checksum::of(transfer.getTo());
+  auto dest = QFileInfo(transfer.getTo());
+
+  if (hash) {
+    Sidecar::Record record;
+    record.hash      = *hash;
+    record.srcSize   = identity.size;
+    record.srcMtime  = identity.mtime / 1000000;
+    record.destSize  = dest.size();
+    record.destMtime = dest.lastModified().toMSecsSinceEpoch();
+    record.srcId     = {identity.device, identity.inode};
+    Sidecar::save(transfer.getTo(), record);
+    Dedup::instance().insert(transfer.getTo(), *hash);
+  }
+
+  // leave nothing of a bulk copy behind in the page cache
+  if (mode != Mode::BUFFERED) {
+    ::posix_fadvise(handles.src, 0, 0, POSIX_FADV_DONTNEED);
+    ::posix_fadvise(handles.dest, 0, 0, POSIX_FADV_DONTNEED);
+  }
+
+  // the journal is no longer needed
+  if (journaled) {
+    checkpoint.remove();
+  }
+
+  // emit the end signal
+  emit this->onCopyEnd(transfer);
+}
+
+/**
+ * @brief Cancel the copy
+ */
+void Copier::cancel() {
+  cancelFlag = true;
+}
+
+/**
+ * @brief The source has a newer version than the one being copied,
+ * checked at the next chunk so the copy goes on if the source only grew
+ */
+void Copier::supersede() {
+  staleFlag = true;
+}
+
+/**
+ * @brief Is Cancelled
+ */
+bool Copier::isCancelled() const {
+  return cancelFlag;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
@@ -0,0 +1,210 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+#ifdef __linux__  // only linux
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QPair>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+
+#include "common/bufferpool/bufferpool.hpp"
+#include "common/checkpoint/checkpoint.hpp"
+#include "common/checksum/checksum.hpp"
+#include "common/copier/icopier.hpp"
+#include "common/copier/linux/committer.hpp"
+#include "common/dedup/dedup.hpp"
+#include "common/governor/governor.hpp"
+#include "common/metrics/metrics.hpp"
+#include "common/progress/progress.hpp"
+#include "common/scheduler/scheduler.hpp"
+#include "common/sidecar/sidecar.hpp"
+#include "common/trace/trace.hpp"
+#include "models/stats/stats.hpp"
+#include "models/transfer/transfer.hpp"
+#include "utility/deferred/deferred.hpp"
+#include "utility/functions/functions.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief A Class that copies a file from one location to another
+ * with a progress signal, the data is staged in a part file next to
+ * the destination with a checkpoint journal so that the copy can be
+ * resumed after a crash or a retry
+ */
+class Copier : public ICopier {
+ private:
+
+  Q_DISABLE_COPY(Copier)
+
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ public:
+
+  /**
+   * @brief How the data moves through the page cache
+   */
+  enum class Mode {
+    BUFFERED,   // plain page cache I/O for small files
+    STREAMING,  // page cache with read ahead and drop behind
+    DIRECT      // O_DIRECT with aligned buffers from the pool
+  };
+
+ private:
+  static inline const qint64 checkpointInterval = 64 << 20;
+  static inline const qint64 streamingThreshold = 8 << 20;
+  static inline const qint64 directThreshold    = 256 << 20;
+  static inline const qint64 dropBehind         = 8 << 20;
+  static inline const char *partSuffix          = ".pulldog-part";
+  static inline const char *journalSuffix       = ".pulldog-journal";
+  static inline const char *linkSuffix          = ".pulldog-link";
+  static inline const int maxExtensions         = 16;
+
+ private:
+  // range of the source and whether it holds data or a hole
+  using Piece = QPair<Checkpoint::Range, bool>;
+
+ private:
+  // descriptors of the source and the part file
+  struct Handles {
+    int src        = -1;
+    int dest       = -1;
+    int srcDirect  = -1;
+    int destDirect = -1;
+  };
+
+ private:
+  std::atomic<bool> cancelFlag = false;
+  std::atomic<bool> staleFlag  = false;
+  const models::Transfer transfer;
+  Checkpoint::Identity identity;
+  models::TransferStats stats;
+  BufferPool::Buffer buffer;
+  Checksum checksum;
+  Mode mode = Mode::BUFFERED;
+  bool hashing   = false;
+  bool journaled = false;
+  bool anonymous = false;
+  bool deduped   = false;
+  bool sparse    = false;
+  Handles handles;
+  Progress progress;
+
+ private:
+  /**
+   * @brief Mode for a file of the size
+   */
+  static Mode modeOf(qint64 size);
+
+  /**
+   * @brief Name of the mode
+   */
+  static QString nameOf(Mode mode);
+
+  /**
+   * @brief Open the O_DIRECT descriptors, falls back on failure
+   */
+  void openDirect(const QByteArray &from, const QByteArray &part);
+
+  /**
+   * @brief Close all descriptors
+   */
+  void closeHandles();
+
+  /**
+   * @brief Path of the staged file with the suffix
+   */
+  QString stagedFile(const char *suffix) const;
+
+  /**
+   * @brief Identity of the file from the stat
+   */
+  static Checkpoint::Identity identityOf(const struct stat &info);
+
+  /**
+   * @brief Materialize the destination from an identical local
+   * file by reflink or hard link, returns errno
+   */
+  int cloneFrom(const QString &match, const QByteArray &to, const struct stat &info);
+
+  /**
+   * @brief Split the range of the source into data and hole pieces
+   */
+  QList<Piece> extentsOf(qint64 begin, qint64 end) const;
+
+  /**
+   * @brief Account the hole in the range as copied, returns errno
+   */
+  int skipHole(Checkpoint &checkpoint, qint64 begin, qint64 end);
+
+  /**
+   * @brief has the source been replaced or rewritten since the copy started
+   */
+  bool isSuperseded() const;
+
+  /**
+   * @brief Copy the range and checkpoint it, returns errno
+   */
+  int copyRange(Checkpoint &checkpoint, qint64 begin, qint64 end);
+
+ public:
+
+  /**
+   * @brief Write the whole data at the offset, returns errno
+   */
+  static int writeAll(int fd, const char *data, qint64 length, qint64 offset);
+
+  /**
+   * @brief Give the unnamed file fd its final name through the
+   * hidden link if the name is taken, returns errno
+   */
+  static int linkInto(int fd, const QByteArray &to, const QByteArray &link);
+
+  /**
+   * @brief Construct a new Copier object
+   */
+  Copier(models::Transfer transfer, QObject *parent = nullptr);
+
+  /**
+   * @brief Destroy the Copier object
+   */
+  virtual ~Copier() = default;
+
+  /**
+   * @brief start
+   */
+  void start() override;
+
+  /**
+   * @brief Cancel the copy
+   */
+  void cancel() override;
+
+  /**
+   * @brief is Cancelled
+   */
+  bool isCancelled() const override;
+
+  /**
+   * @brief The source has a newer version than the one being copied
+   */
+  void supersede() override;
+};
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
@@ -0,0 +1,537 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "fanoutcopier.hpp"
+
+#ifdef __linux__
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Open the staged file of the target, an unnamed file is used
+ * where the file system has them so nobody sees it half written
+ */
+int FanoutCopier::open(Target *target) {
+  auto info   = QFileInfo(target->transfer.getTo());
+  target->dir = info.dir().path();
+
+  target->fd        = ::open(QFile::encodeName(target->dir).constData(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+  target->anonymous = target->fd >= 0;
+
+  if (target->anonymous) {
+    return 0;
+  }
+
+  target->part = info.dir().filePath("." + info.fileName() + partSuffix);
+  target->fd   = ::open(QFile::encodeName(target->part).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  return target->fd < 0 ? errno : 0;
+}
+
+/**
+ * @brief does the target still write from the window, needs the lock
+ */
+bool FanoutCopier::isAttached(const Target *target) {
+  return !target->detached && !target->error;
+}
+
+/**
+ * @brief Wait until the slot of the chunk is free, the slot is held by
+ * whoever has not written the chunk a window ago, the leader is waited
+ * for while the ones lagging a whole window behind it are detached
+ */
+void FanoutCopier::makeRoom(QMutexLocker<QMutex> &locker, qint64 chunk) {
+  auto limit = chunk - windowChunks;
+
+  while (!cancelFlag) {
+    qint64 leader = -1;
+
+    for (const auto *target : active) {
+      if (isAttached(target)) {
+        leader = std::max(leader, target->next);
+      }
+    }
+
+    for (auto *target : active) {
+      if (leader > limit && isAttached(target) && target->next <= limit) {
+        target->detached = true;
+        condition.wakeAll();
+      }
+    }
+
+    // a detached target may still write its last chunk from the window
+    auto held = std::any_of(active.cbegin(), active.cend(), [limit](const Target *target) {
+      return (isAttached(target) || target->writing) && target->next <= limit;
+    });
+
+    if (!held) {
+      return;
+    }
+
+    condition.wait(locker.mutex(), 100);
+  }
+}
+
+/**
+ * @brief Read the source into the window once for all the targets, the
+ * reading stops early once no target writes from the window anymore
+ */
+int FanoutCopier::read() {
+  qint64 offset = 0;
+
+  for (qint64 chunk = 0; offset < size; chunk++) {
+    // a more urgent copy may pause us here
+    Scheduler::instance().yield(static_cast<ICopier *>(this), size - offset);
+
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    // the bytes of a newer version would be mixed with these
+    if (staleFlag.exchange(false) && this->isSuperseded()) {
+      return ECANCELED;
+    }
+
+    QMutexLocker locker(&mutex);
+    this->makeRoom(locker, chunk);
+
+    if (std::none_of(active.cbegin(), active.cend(), isAttached)) {
+      break;
+    }
+
+    locker.unlock();
+
+    auto length = std::min(chunkSize, size - offset);
+    auto slot   = chunk % windowChunks;
+    auto data   = window[slot].data();
+
+    for (qint64 done = 0; done < length;) {
+      auto read = ::pread(src, data + done, length - done, offset + done);
+
+      if (read < 0 && errno == EINTR) {
+        continue;
+      }
+
+      if (read < 0) {
+        return errno;
+      }
+
+      // source is truncated underneath us
+      if (read == 0) {
+        return ESTALE;
+      }
+
+      done += read;
+    }
+
+    // pay for the chunk once it is read, a retried read isn't charged twice
+    auto throttled = Governor::instance().acquire(transfers.first().getFrom(), length, &cancelFlag);
+
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    checksum.update(data, length);
+    offset += length;
+
+    locker.relock();
+    lengths[slot] = length;
+    produced      = chunk + 1;
+    condition.wakeAll();
+
+    // a detached target pays for its own reads
+    for (auto *target : std::as_const(active)) {
+      if (isAttached(target)) target->stats.throttled += throttled;
+    }
+  }
+
+  whole = offset >= size;
+
+  return 0;
+}
+
+/**
+ * @brief Write the window to the target, once detached the rest
+ * of the source is read by the target itself
+ */
+void FanoutCopier::write(Target *target) {
+  QMutexLocker locker(&mutex);
+
+  while (true) {
+    while (!target->detached && target->next >= produced && !finished && !cancelFlag) {
+      condition.wait(&mutex, 100);
+    }
+
+    if (cancelFlag) {
+      target->error = ECANCELED;
+      break;
+    }
+
+    if (target->detached) {
+      auto offset = target->next * chunkSize;
+      locker.unlock();
+      auto error = this->catchUp(target, offset);
+      locker.relock();
+      target->error = error;
+      break;
+    }
+
+    if (target->next >= produced) {
+      break;
+    }
+
+    auto slot   = target->next % windowChunks;
+    auto offset = target->next * chunkSize;
+    auto length = lengths[slot];
+    auto data   = window[slot].constData();
+
+    target->writing = true;
+    locker.unlock();
+
+    auto error = Copier::writeAll(target->fd, data, length, offset);
+
+    target->stats.bytes += length;
+    target->progress.add(length);
+
+    // emit progress at a bounded rate
+    if (target->progress.isDue()) {
+      emit onCopy(target->transfer, target->progress.percent());
+    }
+
+    locker.relock();
+    target->writing = false;
+    target->error   = error;
+    target->next++;
+    condition.wakeAll();
+
+    if (error) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Read the rest of the source for a detached target, it pays
+ * for its bytes like any other copy
+ */
+int FanoutCopier::catchUp(Target *target, qint64 offset) {
+  auto fd = ::open(QFile::encodeName(target->transfer.getFrom()).constData(), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    return errno;
+  }
+
+  DEFER([fd] { ::close(fd); });
+
+  auto buffer = BufferPool::instance().acquire();
+
+  while (offset < size) {
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    auto length = std::min(buffer.size(), size - offset);
+    auto read   = ::pread(fd, buffer.data(), length, offset);
+
+    if (read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (read < 0) {
+      return errno;
+    }
+
+    if (read == 0) {
+      return ESTALE;
+    }
+
+    // pay for the chunk once it is read, a retried read isn't charged twice
+    target->stats.throttled += Governor::instance().acquire(target->transfer.getFrom(), read, &cancelFlag);
+
+    if (cancelFlag) {
+      return ECANCELED;
+    }
+
+    if (auto error = Copier::writeAll(target->fd, buffer.data(), read, offset)) {
+      return error;
+    }
+
+    offset += read;
+    target->stats.bytes += read;
+    target->progress.add(read);
+
+    if (target->progress.isDue()) {
+      emit onCopy(target->transfer, target->progress.percent());
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief has the source been replaced or rewritten since the copy started
+ */
+bool FanoutCopier::isSuperseded() const {
+  struct stat path, open;
+
+  if (::stat(QFile::encodeName(transfers.first().getFrom()).constData(), &path) != 0 || ::fstat(src, &open) != 0) {
+    return true;
+  }
+
+  if (path.st_dev != open.st_dev || path.st_ino != open.st_ino) {
+    return true;
+  }
+
+  return open.st_size != size || open.st_mtim.tv_sec * 1000000000LL + open.st_mtim.tv_nsec != mtime;
+}
+
+/**
+ * @brief Construct a new FanoutCopier object, all the transfers
+ * share the source
+ */
+FanoutCopier::FanoutCopier(const QList<models::Transfer> &transfers, QObject *parent)
+: ICopier(parent), transfers(transfers) {
+  for (const auto &transfer : transfers) {
+    targets.append(new Target(transfer));
+  }
+}
+
+/**
+ * @brief Destroy the FanoutCopier object
+ */
+FanoutCopier::~FanoutCopier() {
+  qDeleteAll(targets);
+}
+
+/**
+ * @brief start
+ */
+void FanoutCopier::start() {
+  PULLDOG_TRACE_SPAN_ID("FanoutCopier::start", qHash(transfers.first().getTo()));
+
+  for (const auto &transfer : transfers) {
+    emit this->onCopyStart(transfer);
+  }
+
+  // the targets that are not up to date, live until they fail
+  QList<Target *> live;
+  QList<Target *> stale;
+
+  // report the stats of the targets that were copied on every exit
+  QElapsedTimer timer;
+  timer.start();
+
+  DEFER([&] {
+    for (auto *target : stale) {
+      target->stats.elapsed = timer.elapsed();
+      target->stats.mode    = target->detached ? "fanout+detached" : "fanout";
+      emit this->onCopyStats(target->transfer, target->stats);
+    }
+  });
+
+  // descriptors are closed on every exit
+  DEFER([this] {
+    for (auto *target : targets) {
+      if (target->fd >= 0) ::close(target->fd);
+      target->fd = -1;
+    }
+
+    if (src >= 0) ::close(src);
+    src = -1;
+  });
+
+  for (auto *target : targets) {
+    auto &transfer = target->transfer;
+
+    if (QFileInfo::exists(transfer.getTo()) && Sidecar::isUptoDate(transfer.getFrom(), transfer.getTo())) {
+      emit this->onCopyEnd(transfer);
+    } else {
+      live.append(target);
+      stale.append(target);
+    }
+  }
+
+  // fails every live target with the error
+  const auto fail = [&](int error) {
+    for (auto *target : live) {
+      if (!target->part.isEmpty()) QFile::remove(target->part);
+      emit this->onCopyFailed(target->transfer, error);
+    }
+  };
+
+  if (live.isEmpty()) {
+    return;
+  }
+
+  // open the source once for all
+  if ((src = ::open(QFile::encodeName(transfers.first().getFrom()).constData(), O_RDONLY | O_CLOEXEC)) < 0) {
+    return fail(errno);
+  }
+
+  struct stat info;
+
+  if (::fstat(src, &info) != 0) {
+    return fail(errno);
+  }
+
+  size  = info.st_size;
+  mtime = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+  id    = {info.st_dev, info.st_ino};
+
+  // a target that can't be staged fails alone
+  for (auto *target : std::as_const(live)) {
+    if (auto error = this->open(target)) {
+      live.removeOne(target);
+      emit this->onCopyFailed(target->transfer, error);
+    }
+  }
+
+  if (live.isEmpty()) {
+    return;
+  }
+
+  // the window the targets write from
+  chunkSize = BufferPool::instance().getBufferSize();
+  window.fill(QByteArray(chunkSize, Qt::Uninitialized), windowChunks);
+  lengths.fill(0, windowChunks);
+  active = live;
+
+  for (auto &slot : window) {
+    slot.detach();
+  }
+
+  ::posix_fadvise(src, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  // every target writes on a thread of its own
+  for (auto *target : std::as_const(active)) {
+    target->progress.setTotal(size);
+    target->thread = QThread::create([this, target] { this->write(target); });
+    target->thread->start();
+  }
+
+  auto error = this->read();
+
+  // the targets finish what is in the window
+  QMutexLocker locker(&mutex);
+  finished = true;
+  condition.wakeAll();
+  locker.unlock();
+
+  for (auto *target : std::as_const(active)) {
+    target->thread->wait();
+    delete std::exchange(target->thread, nullptr);
+  }
+
+  // the staged files are useless but the source is left alone
+  if (error == ECANCELED || cancelFlag) {
+    for (auto *target : std::as_const(active)) {
+      if (!target->part.isEmpty()) QFile::remove(target->part);
+      emit this->onCopyCanceled(target->transfer);
+    }
+
+    return;
+  }
+
+  live = active;
+
+  if (error) {
+    return fail(error);
+  }
+
+  // the source changed while copying
+  if (::fstat(src, &info) != 0 || this->isSuperseded()) {
+    return fail(ESTALE);
+  }
+
+  // commit the targets that made it together
+  QList<Committer::Entry> entries;
+  QList<Target *> committing;
+  struct timespec times[2] = {info.st_atim, info.st_mtim};
+
+  for (auto *target : std::as_const(active)) {
+    if (target->error) {
+      if (!target->part.isEmpty()) QFile::remove(target->part);
+      emit this->onCopyFailed(target->transfer, target->error);
+      continue;
+    }
+
+    // keep the modification time like CopyFileEx does
+    ::futimens(target->fd, times);
+
+    // the old sidecar no longer describes the destination
+    Sidecar::remove(target->transfer.getTo());
+
+    auto to   = QFile::encodeName(target->transfer.getTo());
+    auto part = QFile::encodeName(target->part);
+    auto link = QFile::encodeName(QFileInfo(target->transfer.getTo()).dir().filePath(
+      "." + QFileInfo(target->transfer.getTo()).fileName() + linkSuffix
+    ));
+
+    const auto publish = [target, to, part, link]() -> int {
+      if (target->anonymous) {
+        return Copier::linkInto(target->fd, to, link);
+      }
+
+      return ::rename(part.constData(), to.constData()) == 0 ? 0 : errno;
+    };
+
+    entries.append(Committer::Entry{target->fd, target->dir, publish});
+    committing.append(target);
+  }
+
+  auto results = Committer::instance().commit(entries);
+
+  for (qsizetype i = 0; i < committing.size(); ++i) {
+    auto *target   = committing[i];
+    auto &transfer = target->transfer;
+
+    if (results[i]) {
+      emit this->onCopyFailed(transfer, results[i]);
+      continue;
+    }
+
+    auto hash = whole ? std::optional<quint64>(checksum.digest()) : Checksum::of(transfer.getTo());
+    auto dest = QFileInfo(transfer.getTo());
+
+    if (hash) {
+      Sidecar::Record record;
+      record.hash      = *hash;
+      record.srcSize   = size;
+      record.srcMtime  = mtime / 1000000;
+      record.destSize  = dest.size();
+      record.destMtime = dest.lastModified().toMSecsSinceEpoch();
+      record.srcId     = id;
+      Sidecar::save(transfer.getTo(), record);
+      Dedup::instance().insert(transfer.getTo(), *hash);
+    }
+
+    emit this->onCopyEnd(transfer);
+  }
+
+  // leave nothing of the copy behind in the page cache
+  ::posix_fadvise(src, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+/**
+ * @brief Cancel the copy
+ */
+void FanoutCopier::cancel() {
+  cancelFlag = true;
+}
+
+/**
+ * @brief The source has a newer version than the one being copied,
+ * checked at the next chunk
+ */
+void FanoutCopier::supersede() {
+  staleFlag = true;
+}
+
+/**
+ * @brief Is Cancelled
+ */
+bool FanoutCopier::isCancelled() const {
+  return cancelFlag;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
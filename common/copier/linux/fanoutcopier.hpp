@@ -0,0 +1,180 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+#ifdef __linux__  // only linux
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QPair>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <optional>
+#include <utility>
+
+#include "common/bufferpool/bufferpool.hpp"
+#include "common/checksum/checksum.hpp"
+#include "common/copier/icopier.hpp"
+#include "common/copier/linux/committer.hpp"
+#include "common/copier/linux/copier.hpp"
+#include "common/dedup/dedup.hpp"
+#include "common/governor/governor.hpp"
+#include "common/progress/progress.hpp"
+#include "common/scheduler/scheduler.hpp"
+#include "common/sidecar/sidecar.hpp"
+#include "common/trace/trace.hpp"
+#include "models/stats/stats.hpp"
+#include "models/transfer/transfer.hpp"
+#include "utility/deferred/deferred.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief A Class that copies one source to several destinations while
+ * reading it once, the chunks go through a bounded window that every
+ * destination writes from on a thread of its own, a destination that
+ * falls a whole window behind is detached and reads the rest of the
+ * source by itself so it never holds the others back, every destination
+ * is committed and reported on its own
+ */
+class FanoutCopier : public ICopier {
+ private:
+
+  Q_DISABLE_COPY(FanoutCopier)
+
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ private:
+  static inline const qint64 windowChunks = 16;
+  static inline const char *partSuffix    = ".pulldog-part";
+  static inline const char *linkSuffix    = ".pulldog-link";
+
+ private:
+  // a destination of the source
+  struct Target {
+    models::Transfer transfer;
+    models::TransferStats stats;
+    Progress progress;
+    QString dir;
+    QString part;            // staged file if it can't be unnamed
+    int fd         = -1;
+    int error      = 0;
+    qint64 next    = 0;      // chunk it writes next
+    bool anonymous = false;
+    bool detached  = false;  // reads the source by itself
+    bool writing   = false;  // writes from the window
+    QThread *thread = nullptr;
+
+    Target(const models::Transfer &transfer) : transfer(transfer) {}
+  };
+
+ private:
+  std::atomic<bool> cancelFlag = false;
+  std::atomic<bool> staleFlag  = false;
+  const QList<models::Transfer> transfers;
+  QList<Target *> targets;  // all of them, owned
+  QList<Target *> active;   // the ones being copied
+  QVector<QByteArray> window;
+  QVector<qint64> lengths;
+  qint64 chunkSize = 0;
+  qint64 produced  = 0;      // chunks read into the window
+  qint64 size      = 0;
+  qint64 mtime     = 0;      // ns since epoch
+  QPair<quint64, quint64> id = {0, 0};  // device and inode
+  bool finished    = false;  // nothing more comes into the window
+  bool whole       = false;  // the checksum saw every byte
+  Checksum checksum;
+  QWaitCondition condition;
+  QMutex mutex;
+  int src = -1;
+
+ private:
+  /**
+   * @brief Open the staged file of the target, returns errno
+   */
+  int open(Target *target);
+
+  /**
+   * @brief does the target still write from the window, needs the lock
+   */
+  static bool isAttached(const Target *target);
+
+  /**
+   * @brief Wait until the slot of the chunk is free, detaching the
+   * targets that lag a whole window behind the leader, needs the lock
+   */
+  void makeRoom(QMutexLocker<QMutex> &locker, qint64 chunk);
+
+  /**
+   * @brief Read the source into the window, returns errno
+   */
+  int read();
+
+  /**
+   * @brief Write the window or the source to the target
+   */
+  void write(Target *target);
+
+  /**
+   * @brief Read the rest of the source for a detached target, returns errno
+   */
+  int catchUp(Target *target, qint64 offset);
+
+  /**
+   * @brief has the source been replaced or rewritten since the copy started
+   */
+  bool isSuperseded() const;
+
+ public:
+
+  /**
+   * @brief Construct a new FanoutCopier object
+   */
+  FanoutCopier(const QList<models::Transfer> &transfers, QObject *parent = nullptr);
+
+  /**
+   * @brief Destroy the FanoutCopier object
+   */
+  virtual ~FanoutCopier();
+
+  /**
+   * @brief start
+   */
+  void start() override;
+
+  /**
+   * @brief Cancel the copy
+   */
+  void cancel() override;
+
+  /**
+   * @brief is Cancelled
+   */
+  bool isCancelled() const override;
+
+  /**
+   * @brief The source has a newer version than the one being copied
+   */
+  void supersede() override;
+};
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
@@ -5,6 +5,7 @@
 
 #include "copier.hpp"
 
+#ifdef _WIN32
 namespace srilakshmikanthanp::pulldog::common {
 /**
  * @brief Copy file call back from CopyFileEx
@@ -20,26 +21,43 @@ DWORD CALLBACK Copier::copyFileCallBack(
   HANDLE hDestinationFile,
   LPVOID lpData
 ) {
-  auto progress = (static_cast<double>(totalBytesTransferred.QuadPart) / totalFileSize.QuadPart) * 100;
   auto copier = reinterpret_cast<Copier *>(lpData);
-  QMutexLocker locker(&copier->mutex);
+  auto chunk = totalBytesTransferred.QuadPart - copier->stats.bytes;
 
-  // check if handle is valid since the network drive may disconnected
-  if(!QFileInfo(copier->transfer.getFrom()).exists()) {
-    return PROGRESS_STOP;
-  }
+  // pay for the chunk before the next one goes over the wire
+  copier->stats.throttled += Governor::instance().acquire(copier->transfer.getFrom(), chunk);
+  copier->stats.bytes = totalBytesTransferred.QuadPart;
 
-  if(!QFileInfo(copier->transfer.getTo()).exists()) {
-    return PROGRESS_STOP;
-  }
+  // just a store, the progress is sampled below
+  copier->progress.setTotal(totalFileSize.QuadPart);
+  copier->progress.setDone(totalBytesTransferred.QuadPart);
+
+  // a more urgent copy may pause us here
+  Scheduler::instance().yield(
+    static_cast<ICopier *>(copier), totalFileSize.QuadPart - totalBytesTransferred.QuadPart
+  );
 
   // if cancel flag is set return 1 to cancel the copy
   if (copier->cancelFlag) {
     return PROGRESS_CANCEL;
   }
 
-  // emit progress
-  copier->emit onCopy(copier->transfer, progress);
+  // a disconnected share mostly shows up as a failed read, the rare
+  // hang is caught by probing the open source handle now and then
+  if (copier->probeTimer.hasExpired(probeInterval)) {
+    BY_HANDLE_FILE_INFORMATION info;
+
+    if (!GetFileInformationByHandle(hSourceFile, &info)) {
+      return PROGRESS_STOP;
+    }
+
+    copier->probeTimer.restart();
+  }
+
+  // emit progress at a bounded rate
+  if (copier->progress.isDue()) {
+    copier->emit onCopy(copier->transfer, copier->progress.percent());
+  }
 
   // return 0 to continue the copy
   return PROGRESS_CONTINUE;
@@ -61,6 +79,8 @@ Copier::Copier(models::Transfer transfer, QObject *parent)
  * @brief start
  */
 void Copier::start() {
+  PULLDOG_TRACE_SPAN_ID("Copier::start", qHash(transfer.getTo()));
+
   // get the from and to of the transfer
   auto from = transfer.getFrom();
   auto to = transfer.getTo();
@@ -68,13 +88,23 @@ void Copier::start() {
   // emit the started signal
   emit this->onCopyStart(transfer);
 
+  // report the stats on every exit
+  QElapsedTimer timer;
+  timer.start();
+  probeTimer.start();
+
+  DEFER([&] {
+    stats.elapsed = timer.elapsed();
+    emit this->onCopyStats(transfer, stats);
+  });
+
   // copy file blocking
   if (this->jobDone = CopyFileEx(
     reinterpret_cast<LPCWSTR>(from.utf16()),
     reinterpret_cast<LPCWSTR>(to.utf16()),
     copyFileCallBack,
     this,
-    &cancelFlag,
+    reinterpret_cast<LPBOOL>(const_cast<LONG *>(&cancelFlag)),
     COPY_FILE_FAIL_IF_EXISTS  |
     COPY_FILE_RESTARTABLE     |
     COPY_FILE_NO_BUFFERING
@@ -106,9 +136,8 @@ void Copier::start() {
  * @brief Cancel the copy
  */
 void Copier::cancel() {
-  QMutexLocker locker(&mutex);
   if(!jobDone) {
-    this->cancelFlag = true;
+    InterlockedExchange(&cancelFlag, TRUE);
   }
 }
 
@@ -119,3 +148,4 @@ bool Copier::isCancelled() const {
   return cancelFlag;
 }
 } // namespace srilakshmikanthanp::pulldog::common
+#endif  // _WIN32
@@ -1,16 +1,16 @@
 #pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+#ifdef _WIN32  // only windows
 
 // Copyright (c) 2024 Sri Lakshmi Kanthan P
 //
 // This software is released under the MIT License.
 // https://opensource.org/licenses/MIT
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QLockFile>
 #include <QObject>
 #include <QThread>
-#include <QMutex>
-#include <QMutexLocker>
 
 #define NOMINMAX
 #include <windows.h>
@@ -19,8 +19,14 @@
 #include <atomic>
 
 #include "common/copier/icopier.hpp"
+#include "common/governor/governor.hpp"
 #include "common/locker/locker.hpp"
+#include "common/progress/progress.hpp"
+#include "common/scheduler/scheduler.hpp"
+#include "common/trace/trace.hpp"
+#include "models/stats/stats.hpp"
 #include "models/transfer/transfer.hpp"
+#include "utility/deferred/deferred.hpp"
 #include "utility/functions/functions.hpp"
 
 namespace srilakshmikanthanp::pulldog::common {
@@ -37,11 +43,16 @@ class Copier : public ICopier {
 
   Q_OBJECT
 
+ private:
+  static inline const qint64 probeInterval = 5000;
+
  private:
   std::atomic<bool> jobDone = false;
   const models::Transfer transfer;
-  BOOL cancelFlag = false;
-  QMutex mutex;
+  models::TransferStats stats;
+  volatile LONG cancelFlag = FALSE;
+  QElapsedTimer probeTimer;
+  Progress progress;
 
  public:
 
@@ -87,3 +98,4 @@ class Copier : public ICopier {
   );
 };
 }  // namespace srilakshmikanthanp::pulldog::common::copier
+#endif  // _WIN32
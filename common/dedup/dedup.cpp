@@ -0,0 +1,270 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "dedup.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Construct a new Dedup object
+ */
+Dedup::Dedup() {
+  file = QDir(QString::fromStdString(constants::getAppHome())).filePath("dedup.index");
+  this->load();
+}
+
+/**
+ * @brief Destroy the Dedup object
+ */
+Dedup::~Dedup() {
+  QMutexLocker locker(&mutex);
+
+  if (unsaved) {
+    this->save();
+  }
+}
+
+/**
+ * @brief Load the index from disk, a corrupt index is dropped
+ * since it only saves work and never decides correctness
+ */
+void Dedup::load() {
+  QFile index(file);
+
+  if (!index.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  // payload followed by its checksum
+  auto data = index.readAll();
+
+  if (data.size() < static_cast<qsizetype>(sizeof(quint16))) {
+    return;
+  }
+
+  auto payload = data.left(data.size() - sizeof(quint16));
+  QDataStream tail(data.right(sizeof(quint16)));
+  quint16 checksum;
+  tail >> checksum;
+
+  if (checksum != qChecksum(payload)) {
+    return;
+  }
+
+  QDataStream stream(payload);
+  quint32 fileMagic;
+  quint16 fileVersion;
+  quint32 count;
+
+  stream >> fileMagic >> fileVersion >> count;
+
+  if (fileMagic != magic || fileVersion != version) {
+    return;
+  }
+
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+    qint64 size;
+    Entry entry;
+    stream >> size >> entry.path >> entry.hash >> entry.prefix >> entry.mtime;
+
+    if (stream.status() == QDataStream::Ok) {
+      entries.insert(size, entry);
+      sizes.insert(entry.path, size);
+    }
+  }
+}
+
+/**
+ * @brief Atomically replace the index on disk
+ */
+void Dedup::save() {
+  QByteArray payload;
+  QDataStream stream(&payload, QIODevice::WriteOnly);
+
+  stream << magic << version << static_cast<quint32>(entries.size());
+
+  for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+    stream << it.key() << it->path << it->hash << it->prefix << it->mtime;
+  }
+
+  QByteArray tail;
+  QDataStream(&tail, QIODevice::WriteOnly) << qChecksum(payload);
+
+  QDir().mkpath(QFileInfo(file).dir().path());
+  QSaveFile index(file);
+
+  if (!index.open(QIODevice::WriteOnly)) {
+    return;
+  }
+
+  index.write(payload);
+  index.write(tail);
+
+  if (index.commit()) {
+    unsaved = 0;
+  }
+}
+
+/**
+ * @brief Drop the entry of the path, needs the lock
+ */
+void Dedup::erase(const QString &path) {
+  if (!sizes.contains(path)) {
+    return;
+  }
+
+  auto size = sizes.take(path);
+
+  for (auto it = entries.find(size); it != entries.end() && it.key() == size;) {
+    it = it->path == path ? entries.erase(it) : std::next(it);
+  }
+
+  unsaved++;
+}
+
+/**
+ * @brief Enable or disable the dedup
+ */
+void Dedup::setEnabled(bool enabled) {
+  this->enabled = enabled;
+}
+
+/**
+ * @brief is the dedup enabled
+ */
+bool Dedup::isEnabled() const {
+  return enabled;
+}
+
+/**
+ * @brief Set how candidates are confirmed
+ */
+void Dedup::setConfirm(Confirm confirm) {
+  QMutexLocker locker(&mutex);
+  this->confirm = confirm;
+}
+
+/**
+ * @brief Get how candidates are confirmed
+ */
+Dedup::Confirm Dedup::getConfirm() const {
+  QMutexLocker locker(&mutex);
+  return confirm;
+}
+
+/**
+ * @brief Find a destination with the same content as the source, the
+ * size narrows the candidates for free and the hash of the head of the
+ * source is computed only if there is a candidate of the same size, a
+ * match is always confirmed by the hash of the whole source so the hash
+ * it carries is safe to record
+ */
+std::optional<Dedup::Match> Dedup::find(const QString &src) {
+  auto size = QFileInfo(src).size();
+
+  if (!enabled || size < minimumSize) {
+    return std::nullopt;
+  }
+
+  QMutexLocker locker(&mutex);
+  auto candidates = entries.values(size);
+  auto mode       = confirm;
+  locker.unlock();
+
+  if (candidates.isEmpty()) {
+    return std::nullopt;
+  }
+
+  auto prefix = Checksum::sample(src, 1, blockSize);
+
+  if (!prefix) {
+    return std::nullopt;
+  }
+
+  // hash of the whole source is computed at most once
+  std::optional<quint64> full;
+
+  for (const auto &candidate : candidates) {
+    if (candidate.prefix != *prefix) {
+      continue;
+    }
+
+    // the destination was changed or removed since it was indexed
+    auto info = QFileInfo(candidate.path);
+
+    if (info.size() != size || info.lastModified().toMSecsSinceEpoch() != candidate.mtime) {
+      this->remove(candidate.path);
+      continue;
+    }
+
+    // spread out blocks throw a near miss away before the whole source is read
+    if (mode == Confirm::SAMPLED) {
+      auto ours   = Checksum::sample(src, sampleCount, blockSize);
+      auto theirs = Checksum::sample(candidate.path, sampleCount, blockSize);
+
+      if (!ours || !theirs || *ours != *theirs) {
+        continue;
+      }
+    }
+
+    // only the hash of the whole source confirms the content is the same
+    full = full ? full : Checksum::of(src);
+
+    if (full && *full == candidate.hash) {
+      return Match{candidate.path, candidate.hash};
+    }
+  }
+
+  return std::nullopt;
+}
+
+/**
+ * @brief Record the completed destination with its content hash,
+ * the head is hashed from the local destination
+ */
+void Dedup::insert(const QString &dest, quint64 hash) {
+  auto info = QFileInfo(dest);
+
+  if (!enabled || info.size() < minimumSize) {
+    return;
+  }
+
+  auto prefix = Checksum::sample(dest, 1, blockSize);
+
+  if (!prefix) {
+    return;
+  }
+
+  Entry entry;
+  entry.path   = dest;
+  entry.hash   = hash;
+  entry.prefix = *prefix;
+  entry.mtime  = info.lastModified().toMSecsSinceEpoch();
+
+  QMutexLocker locker(&mutex);
+  this->erase(dest);
+  entries.insert(info.size(), entry);
+  sizes.insert(dest, info.size());
+
+  if (++unsaved >= saveInterval) {
+    this->save();
+  }
+}
+
+/**
+ * @brief Forget the destination
+ */
+void Dedup::remove(const QString &dest) {
+  QMutexLocker locker(&mutex);
+  this->erase(dest);
+}
+
+/**
+ * @brief Instance of the dedup index
+ */
+Dedup &Dedup::instance() {
+  static Dedup instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,152 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMultiHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QString>
+
+#include <atomic>
+#include <optional>
+
+#include "common/checksum/checksum.hpp"
+#include "constants/constants.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Local index of the completed destinations keyed by their
+ * content, a new source is matched by its size and a sampled head
+ * first and confirmed by its full hash before the copy is replaced by
+ * a clone
+ */
+class Dedup {
+ private:
+  Q_DISABLE_COPY_MOVE(Dedup)
+
+ public:
+
+  /**
+   * @brief How a candidate is confirmed against the source
+   */
+  enum class Confirm {
+    FULL,     // hash the whole source
+    SAMPLED,  // screen with blocks spread over the source, then hash it whole
+  };
+
+  /**
+   * @brief Destination with the same content as the source
+   */
+  struct Match {
+    QString path;
+    quint64 hash = 0;
+  };
+
+ private:
+  // a completed destination
+  struct Entry {
+    QString path;
+    quint64 hash   = 0;
+    quint64 prefix = 0;
+    qint64 mtime   = 0;  // milliseconds since epoch
+  };
+
+ private:
+  static inline const quint32 magic       = 0x50444458;  // PDDX
+  static inline const quint16 version     = 1;
+  static inline const qint64 minimumSize  = 256 << 10;
+  static inline const qint64 blockSize    = 64 << 10;
+  static inline const int sampleCount     = 16;
+  static inline const int saveInterval    = 64;
+
+ private:
+  QMultiHash<qint64, Entry> entries;  // keyed by size
+  QHash<QString, qint64> sizes;       // size of the entry of a path
+  std::atomic<bool> enabled = false;
+  Confirm confirm = Confirm::FULL;
+  QString file;
+  int unsaved = 0;
+  mutable QMutex mutex;
+
+ private:
+
+  /**
+   * @brief Construct a new Dedup object
+   */
+  Dedup();
+
+  /**
+   * @brief Load the index from disk
+   */
+  void load();
+
+  /**
+   * @brief Atomically replace the index on disk
+   */
+  void save();
+
+  /**
+   * @brief Drop the entry of the path, needs the lock
+   */
+  void erase(const QString &path);
+
+ public:
+
+  /**
+   * @brief Destroy the Dedup object
+   */
+  ~Dedup();
+
+  /**
+   * @brief Enable or disable the dedup
+   */
+  void setEnabled(bool enabled);
+
+  /**
+   * @brief is the dedup enabled
+   */
+  bool isEnabled() const;
+
+  /**
+   * @brief Set how candidates are confirmed
+   */
+  void setConfirm(Confirm confirm);
+
+  /**
+   * @brief Get how candidates are confirmed
+   */
+  Confirm getConfirm() const;
+
+  /**
+   * @brief Find a destination with the same content as the source
+   */
+  std::optional<Match> find(const QString &src);
+
+  /**
+   * @brief Record the completed destination with its content hash
+   */
+  void insert(const QString &dest, quint64 hash);
+
+  /**
+   * @brief Forget the destination
+   */
+  void remove(const QString &dest);
+
+  /**
+   * @brief Instance of the dedup index
+   */
+  static Dedup &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,237 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "governor.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief is the time inside the window
+ */
+bool Governor::Window::contains(const QTime &time) const {
+  if (!from.isValid() || !to.isValid()) {
+    return false;
+  }
+
+  if (from <= to) {
+    return from <= time && time < to;
+  }
+
+  return time >= from || time < to;
+}
+
+/**
+ * @brief Serialize as HH:mm-HH:mm=rate
+ */
+QString Governor::Window::toString() const {
+  return QString("%1-%2=%3").arg(from.toString("HH:mm"), to.toString("HH:mm")).arg(rate);
+}
+
+/**
+ * @brief Parse from HH:mm-HH:mm=rate
+ */
+Governor::Window Governor::Window::fromString(const QString &window) {
+  auto parts = window.split('=');
+  auto times = parts.first().split('-');
+  Window result;
+
+  if (parts.size() != 2 || times.size() != 2) {
+    return result;
+  }
+
+  result.from = QTime::fromString(times[0].trimmed(), "HH:mm");
+  result.to   = QTime::fromString(times[1].trimmed(), "HH:mm");
+  result.rate = parts[1].trimmed().toLongLong();
+
+  return result;
+}
+
+/**
+ * @brief Parse a schedule from its windows as stored
+ */
+QList<Governor::Window> Governor::Window::listFromStrings(const QStringList &windows) {
+  QList<Window> schedule;
+
+  for (const auto &window : windows) {
+    schedule.append(fromString(window));
+  }
+
+  return schedule;
+}
+
+/**
+ * @brief Rate in effect at the time
+ */
+qint64 Governor::Bucket::rate(const QTime &time) const {
+  for (const auto &window : schedule) {
+    if (window.contains(time)) {
+      return window.rate;
+    }
+  }
+
+  return limit;
+}
+
+/**
+ * @brief Refill the tokens for the elapsed time
+ */
+void Governor::Bucket::refill(qint64 rate, qint64 now) {
+  auto elapsed = static_cast<double>(now - last) / 1e9;
+  tokens       = rate > 0 ? std::min<double>(rate, tokens + rate * elapsed) : 0;
+  last         = now;
+}
+
+/**
+ * @brief Construct a new Governor object
+ */
+Governor::Governor() {
+  clock.start();
+}
+
+/**
+ * @brief Bucket of the watch root the file belongs to, the
+ * longest matching root wins
+ */
+Governor::Bucket *Governor::rootOf(const QString &file) {
+  Bucket *bucket = nullptr;
+  qsizetype length = -1;
+
+  for (auto it = roots.begin(); it != roots.end(); ++it) {
+    auto root = it.key();
+
+    if (root.size() <= length || !file.startsWith(root)) {
+      continue;
+    }
+
+    if (file.size() == root.size() || file[root.size()] == '/' || root.endsWith('/')) {
+      bucket = &it.value();
+      length = root.size();
+    }
+  }
+
+  return bucket;
+}
+
+/**
+ * @brief Set the global limit in bytes per second
+ */
+void Governor::setLimit(qint64 rate) {
+  QMutexLocker locker(&mutex);
+  global.limit = rate;
+}
+
+/**
+ * @brief Get the global limit in bytes per second
+ */
+qint64 Governor::getLimit() const {
+  QMutexLocker locker(&mutex);
+  return global.limit;
+}
+
+/**
+ * @brief Set the global schedule
+ */
+void Governor::setSchedule(const QList<Window> &schedule) {
+  QMutexLocker locker(&mutex);
+  global.schedule = schedule;
+}
+
+/**
+ * @brief Get the global schedule
+ */
+QList<Governor::Window> Governor::getSchedule() const {
+  QMutexLocker locker(&mutex);
+  return global.schedule;
+}
+
+/**
+ * @brief Set the limit of the watch root
+ */
+void Governor::setRootLimit(const QString &root, qint64 rate) {
+  QMutexLocker locker(&mutex);
+  roots[QDir::cleanPath(root)].limit = rate;
+}
+
+/**
+ * @brief Set the schedule of the watch root
+ */
+void Governor::setRootSchedule(const QString &root, const QList<Window> &schedule) {
+  QMutexLocker locker(&mutex);
+  roots[QDir::cleanPath(root)].schedule = schedule;
+}
+
+/**
+ * @brief Remove the limits of the watch root
+ */
+void Governor::removeRoot(const QString &root) {
+  QMutexLocker locker(&mutex);
+  roots.remove(QDir::cleanPath(root));
+}
+
+/**
+ * @brief Block until the bytes of the file can be transferred, the
+ * wait is sliced so that live changes to the limits and cancellation
+ * are picked up while waiting
+ */
+qint64 Governor::acquire(const QString &file, qint64 bytes, const std::atomic<bool> *cancel) {
+  QElapsedTimer waited;
+  waited.start();
+
+  while (true) {
+    QMutexLocker locker(&mutex);
+    auto time = QTime::currentTime();
+    auto now  = clock.nsecsElapsed();
+    qint64 wait = 0;
+
+    QList<Bucket *> limited;
+
+    for (auto bucket : {&global, rootOf(file)}) {
+      if (bucket == nullptr) {
+        continue;
+      }
+
+      auto rate = bucket->rate(time);
+      bucket->refill(rate, now);
+
+      if (rate <= 0) {
+        continue;
+      }
+
+      // a chunk larger than the burst only needs a full bucket
+      auto need = std::min(bytes, rate);
+
+      if (bucket->tokens < need) {
+        wait = std::max<qint64>(wait, (need - bucket->tokens) * 1000 / rate + 1);
+      }
+
+      limited.append(bucket);
+    }
+
+    // every bucket can pay, the debt is carried by the tokens
+    if (wait == 0) {
+      for (auto bucket : limited) {
+        bucket->tokens -= bytes;
+      }
+
+      return limited.isEmpty() ? 0 : waited.elapsed();
+    }
+
+    locker.unlock();
+
+    if (cancel && *cancel) {
+      return waited.elapsed();
+    }
+
+    QThread::msleep(std::min(wait, slice));
+  }
+}
+
+/**
+ * @brief Instance of the governor
+ */
+Governor &Governor::instance() {
+  static Governor instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
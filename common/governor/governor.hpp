@@ -0,0 +1,160 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
+#include <QTime>
+
+#include <algorithm>
+#include <atomic>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Bandwidth governor built from hierarchical token buckets,
+ * every chunk has to be paid for in the global bucket and in the
+ * bucket of the watch root it belongs to
+ */
+class Governor {
+ private:
+
+  Q_DISABLE_COPY_MOVE(Governor)
+
+ public:
+
+  /**
+   * @brief Time of day window with its own rate, the window
+   * may wrap around midnight like 22:00-06:00
+   */
+  struct Window {
+    QTime from;
+    QTime to;
+    qint64 rate = 0;  // bytes per second, zero is unlimited
+
+    /**
+     * @brief is the time inside the window
+     */
+    bool contains(const QTime &time) const;
+
+    /**
+     * @brief Serialize as HH:mm-HH:mm=rate
+     */
+    QString toString() const;
+
+    /**
+     * @brief Parse from HH:mm-HH:mm=rate
+     */
+    static Window fromString(const QString &window);
+
+    /**
+     * @brief Parse a schedule from its windows
+     */
+    static QList<Window> listFromStrings(const QStringList &windows);
+  };
+
+ private:
+
+  /**
+   * @brief Token bucket with a burst of one second
+   */
+  struct Bucket {
+    qint64 limit = 0;  // bytes per second outside the schedule
+    QList<Window> schedule;
+    double tokens = 0;
+    qint64 last   = 0;
+
+    /**
+     * @brief Rate in effect at the time
+     */
+    qint64 rate(const QTime &time) const;
+
+    /**
+     * @brief Refill the tokens for the elapsed time
+     */
+    void refill(qint64 rate, qint64 now);
+  };
+
+ private:
+  static inline const qint64 slice = 100;  // longest sleep in ms
+
+ private:
+  QMap<QString, Bucket> roots;
+  QElapsedTimer clock;
+  mutable QMutex mutex;
+  Bucket global;
+
+ private:
+
+  /**
+   * @brief Construct a new Governor object
+   */
+  Governor();
+
+  /**
+   * @brief Bucket of the watch root the file belongs to
+   */
+  Bucket *rootOf(const QString &file);
+
+ public:
+
+  /**
+   * @brief Destroy the Governor object
+   */
+  ~Governor() = default;
+
+  /**
+   * @brief Set the global limit in bytes per second
+   */
+  void setLimit(qint64 rate);
+
+  /**
+   * @brief Get the global limit in bytes per second
+   */
+  qint64 getLimit() const;
+
+  /**
+   * @brief Set the global schedule
+   */
+  void setSchedule(const QList<Window> &schedule);
+
+  /**
+   * @brief Get the global schedule
+   */
+  QList<Window> getSchedule() const;
+
+  /**
+   * @brief Set the limit of the watch root
+   */
+  void setRootLimit(const QString &root, qint64 rate);
+
+  /**
+   * @brief Set the schedule of the watch root
+   */
+  void setRootSchedule(const QString &root, const QList<Window> &schedule);
+
+  /**
+   * @brief Remove the limits of the watch root
+   */
+  void removeRoot(const QString &root);
+
+  /**
+   * @brief Block until the bytes of the file can be transferred,
+   * returns the milliseconds spent waiting
+   */
+  qint64 acquire(const QString &file, qint64 bytes, const std::atomic<bool> *cancel = nullptr);
+
+  /**
+   * @brief Instance of the governor
+   */
+  static Governor &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
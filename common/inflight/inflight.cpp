@@ -0,0 +1,82 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "inflight.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Shard of the transfer
+ */
+InFlight::Shard &InFlight::shardOf(const models::Transfer &transfer) {
+  return table[std::hash<models::Transfer>()(transfer) % shards];
+}
+
+/**
+ * @brief Claim the transfer for the copier, a copier already in flight
+ * is told that its source has a newer version, it either extends the copy
+ * if the source only grew or gives up at the next chunk so the new version
+ * can be claimed by the next attempt
+ */
+bool InFlight::claim(const models::Transfer &transfer, ICopier *copier) {
+  auto &shard = this->shardOf(transfer);
+  QMutexLocker locker(&shard.mutex);
+
+  auto [slot, inserted] = shard.copiers.try_emplace(transfer, copier);
+
+  if (!inserted && slot->second) {
+    slot->second->supersede();
+  }
+
+  return inserted;
+}
+
+/**
+ * @brief Hand the claimed transfer to the copier that runs it
+ */
+void InFlight::assign(const models::Transfer &transfer, ICopier *copier) {
+  auto &shard = this->shardOf(transfer);
+  QMutexLocker locker(&shard.mutex);
+  shard.copiers[transfer] = copier;
+}
+
+/**
+ * @brief Release the transfer if the copier still holds it, the copier
+ * releases from its own thread before it is deleted so a claim never
+ * sees a dangling copier
+ */
+void InFlight::release(const models::Transfer &transfer, const ICopier *copier) {
+  auto &shard = this->shardOf(transfer);
+  QMutexLocker locker(&shard.mutex);
+
+  if (auto slot = shard.copiers.find(transfer); slot != shard.copiers.end() && (!copier || slot->second == copier)) {
+    shard.copiers.erase(slot);
+  }
+}
+
+/**
+ * @brief Cancel every copier in flight, under the lock of its shard
+ * since a copier releases its transfer there before it is deleted
+ */
+void InFlight::cancel() {
+  for (auto &shard : table) {
+    QMutexLocker locker(&shard.mutex);
+
+    for (const auto &[transfer, copier] : shard.copiers) {
+      if (copier) {
+        copier->cancel();
+      }
+    }
+  }
+}
+
+/**
+ * @brief is the transfer in flight
+ */
+bool InFlight::contains(const models::Transfer &transfer) {
+  auto &shard = this->shardOf(transfer);
+  QMutexLocker locker(&shard.mutex);
+  return shard.copiers.count(transfer) > 0;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,85 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+
+#include "common/copier/icopier.hpp"
+#include "models/transfer/transfer.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Table of the transfers in flight, sharded by the hash of the
+ * transfer so the copiers that finish on the pool threads and the worker
+ * never wait on one lock, all changes of a transfer run under the lock of
+ * its shard so the updates of a path are applied one after another
+ */
+class InFlight {
+ private:
+  Q_DISABLE_COPY_MOVE(InFlight)
+
+ private:
+  static inline const size_t shards = 16;
+
+ private:
+  // transfers of a shard, a null copier is claimed but not yet started
+  struct Shard {
+    QMutex mutex;
+    std::unordered_map<models::Transfer, ICopier *> copiers;
+  };
+
+ private:
+  std::array<Shard, shards> table;
+
+ private:
+  /**
+   * @brief Shard of the transfer
+   */
+  Shard &shardOf(const models::Transfer &transfer);
+
+ public:
+  /**
+   * @brief Construct a new InFlight object
+   */
+  InFlight() = default;
+
+  /**
+   * @brief Destroy the InFlight object
+   */
+  ~InFlight() = default;
+
+  /**
+   * @brief Claim the transfer for the copier, a copier already in flight
+   * is told that its source has a newer version and the claim fails
+   */
+  bool claim(const models::Transfer &transfer, ICopier *copier = nullptr);
+
+  /**
+   * @brief Hand the claimed transfer to the copier that runs it
+   */
+  void assign(const models::Transfer &transfer, ICopier *copier);
+
+  /**
+   * @brief Release the transfer if the copier still holds it
+   */
+  void release(const models::Transfer &transfer, const ICopier *copier = nullptr);
+
+  /**
+   * @brief Cancel every copier in flight
+   */
+  void cancel();
+
+  /**
+   * @brief is the transfer in flight
+   */
+  bool contains(const models::Transfer &transfer);
+};
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,267 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "journal.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Construct a new Journal object, the journal is replayed and
+ * compacted before anything is appended
+ */
+Journal::Journal() {
+  auto home = QString::fromStdString(constants::getAppHome());
+  QDir().mkpath(home);
+  file.setFileName(QDir(home).filePath("transfers.journal"));
+
+  QMutexLocker locker(&mutex);
+  this->replay();
+  this->compact();
+}
+
+/**
+ * @brief Destroy the Journal object
+ */
+Journal::~Journal() {
+  QMutexLocker locker(&mutex);
+
+  if (appended) {
+    this->compact();
+  }
+}
+
+/**
+ * @brief A transfer in the state is done with and not kept
+ */
+bool Journal::isTerminal(State state) {
+  return state == State::COMMITTED || state == State::SKIPPED;
+}
+
+/**
+ * @brief Encode the record as its length, the payload and the
+ * checksum of the payload
+ */
+QByteArray Journal::encode(const models::Transfer &transfer, const Record &record) {
+  QByteArray payload;
+  QDataStream(&payload, QIODevice::WriteOnly)
+    << static_cast<quint8>(record.state) << transfer.getFrom() << transfer.getTo() << record.error;
+
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream << static_cast<quint32>(payload.size());
+  stream.writeRawData(payload.constData(), payload.size());
+  stream << qChecksum(payload);
+
+  return data;
+}
+
+/**
+ * @brief Replay the journal into the live state, the replay stops at
+ * the first record that is cut short, longer than what is left of the
+ * file or doesn't match its checksum since nothing after a torn write
+ * can be trusted, the compaction that follows truncates it away
+ */
+void Journal::replay() {
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QDataStream stream(&file);
+  quint32 fileMagic;
+  quint16 fileVersion;
+
+  stream >> fileMagic >> fileVersion;
+
+  if (stream.status() != QDataStream::Ok || fileMagic != magic || fileVersion != version) {
+    return file.close();
+  }
+
+  while (!stream.atEnd()) {
+    quint32 length;
+    quint16 checksum;
+    stream >> length;
+
+    // a length torn or flipped on disk must not size the allocation
+    if (stream.status() != QDataStream::Ok || length > recordLimit || length > file.bytesAvailable()) {
+      break;
+    }
+
+    QByteArray payload(length, Qt::Uninitialized);
+
+    if (stream.readRawData(payload.data(), length) != static_cast<int>(length)) {
+      break;
+    }
+
+    stream >> checksum;
+
+    if (stream.status() != QDataStream::Ok || checksum != qChecksum(payload)) {
+      break;
+    }
+
+    QDataStream record(payload);
+    quint8 state;
+    QString from, to;
+    qint32 error;
+
+    record >> state >> from >> to >> error;
+
+    if (record.status() != QDataStream::Ok) {
+      break;
+    }
+
+    auto transfer = models::Transfer(from, to);
+
+    if (isTerminal(static_cast<State>(state))) {
+      records.remove(transfer);
+    } else {
+      records.insert(transfer, Record{static_cast<State>(state), error});
+    }
+  }
+
+  file.close();
+}
+
+/**
+ * @brief Write the live state as a fresh journal, a copy that was
+ * running is queued again since only the copier knows how far it got,
+ * the journal is replaced atomically and reopened for appending
+ */
+void Journal::compact() {
+  file.close();
+
+  QByteArray header;
+  QDataStream(&header, QIODevice::WriteOnly) << magic << version;
+
+  QSaveFile fresh(file.fileName());
+
+  if (fresh.open(QIODevice::WriteOnly)) {
+    fresh.write(header);
+
+    for (auto it = records.cbegin(); it != records.cend(); ++it) {
+      auto record = it.value();
+
+      if (record.state == State::STARTED) {
+        record.state = State::QUEUED;
+      }
+
+      fresh.write(encode(it.key(), record));
+    }
+
+    fresh.commit();
+  }
+
+  appended = 0;
+  file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+/**
+ * @brief Append the state change, it is flushed to the os right away so
+ * it survives a crash of the process, a repeated state isn't written
+ */
+void Journal::append(const models::Transfer &transfer, State state, qint32 error) {
+  auto record = records.constFind(transfer);
+
+  if (record != records.cend() && record->state == state && record->error == error) {
+    return;
+  }
+
+  if (isTerminal(state) && record == records.cend()) {
+    return;
+  }
+
+  if (isTerminal(state)) {
+    records.remove(transfer);
+  } else {
+    records.insert(transfer, Record{state, error});
+  }
+
+  file.write(encode(transfer, Record{state, error}));
+  file.flush();
+
+  if (++appended >= compactInterval) {
+    this->compact();
+  }
+}
+
+/**
+ * @brief The transfer is waiting for the copy
+ */
+void Journal::queued(const models::Transfer &transfer) {
+  QMutexLocker locker(&mutex);
+  this->append(transfer, State::QUEUED);
+}
+
+/**
+ * @brief The copy of the transfer started
+ */
+void Journal::started(const models::Transfer &transfer) {
+  QMutexLocker locker(&mutex);
+  this->append(transfer, State::STARTED);
+}
+
+/**
+ * @brief The transfer is at the destination
+ */
+void Journal::committed(const models::Transfer &transfer) {
+  QMutexLocker locker(&mutex);
+  this->append(transfer, State::COMMITTED);
+}
+
+/**
+ * @brief The transfer failed with the error
+ */
+void Journal::failed(const models::Transfer &transfer, int error) {
+  QMutexLocker locker(&mutex);
+  this->append(transfer, State::FAILED, error);
+}
+
+/**
+ * @brief The transfer was dropped before the copy since its source
+ * went away, it is forgotten like a committed one
+ */
+void Journal::skipped(const models::Transfer &transfer) {
+  QMutexLocker locker(&mutex);
+  this->append(transfer, State::SKIPPED);
+}
+
+/**
+ * @brief Transfers that were queued or copying
+ */
+QList<models::Transfer> Journal::pending() const {
+  QMutexLocker locker(&mutex);
+  QList<models::Transfer> transfers;
+
+  for (auto it = records.cbegin(); it != records.cend(); ++it) {
+    if (it->state == State::QUEUED || it->state == State::STARTED) {
+      transfers.append(it.key());
+    }
+  }
+
+  return transfers;
+}
+
+/**
+ * @brief Transfers that failed with their error
+ */
+QList<QPair<models::Transfer, int>> Journal::failures() const {
+  QMutexLocker locker(&mutex);
+  QList<QPair<models::Transfer, int>> transfers;
+
+  for (auto it = records.cbegin(); it != records.cend(); ++it) {
+    if (it->state == State::FAILED) {
+      transfers.append(qMakePair(it.key(), static_cast<int>(it->error)));
+    }
+  }
+
+  return transfers;
+}
+
+/**
+ * @brief Instance of the journal
+ */
+Journal &Journal::instance() {
+  static Journal instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
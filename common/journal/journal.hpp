@@ -0,0 +1,143 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QString>
+
+#include "constants/constants.hpp"
+#include "models/transfer/transfer.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Append only journal of the state changes of the transfers, every
+ * record carries its own checksum so a torn tail is cut off on replay, the
+ * live state is kept in memory and written out as a fresh journal now and
+ * then so the committed transfers don't pile up
+ */
+class Journal {
+ private:
+  Q_DISABLE_COPY_MOVE(Journal)
+
+ public:
+  /**
+   * @brief State of a transfer
+   */
+  enum class State : quint8 {
+    QUEUED    = 1,
+    STARTED   = 2,
+    COMMITTED = 3,
+    FAILED    = 4,
+    SKIPPED   = 5,  // the source went away before the copy
+  };
+
+ private:
+  // last state of a transfer
+  struct Record {
+    State state;
+    qint32 error = 0;
+  };
+
+ private:
+  static inline const quint32 magic         = 0x5044544A;  // PDTJ
+  static inline const quint16 version       = 1;
+  static inline const int compactInterval   = 4096;
+  static inline const quint32 recordLimit   = 1 << 20;  // bytes of a payload
+
+ private:
+  QMap<models::Transfer, Record> records;
+  QFile file;
+  int appended = 0;
+  mutable QMutex mutex;
+
+ private:
+  /**
+   * @brief Construct a new Journal object
+   */
+  Journal();
+
+  /**
+   * @brief A transfer in the state is done with
+   */
+  static bool isTerminal(State state);
+
+  /**
+   * @brief Encode the record with its checksum
+   */
+  static QByteArray encode(const models::Transfer &transfer, const Record &record);
+
+  /**
+   * @brief Replay the journal into the live state
+   */
+  void replay();
+
+  /**
+   * @brief Write the live state as a fresh journal, needs the lock
+   */
+  void compact();
+
+  /**
+   * @brief Append the state change, needs the lock
+   */
+  void append(const models::Transfer &transfer, State state, qint32 error = 0);
+
+ public:
+  /**
+   * @brief Destroy the Journal object
+   */
+  ~Journal();
+
+  /**
+   * @brief The transfer is waiting for the copy
+   */
+  void queued(const models::Transfer &transfer);
+
+  /**
+   * @brief The copy of the transfer started
+   */
+  void started(const models::Transfer &transfer);
+
+  /**
+   * @brief The transfer is at the destination
+   */
+  void committed(const models::Transfer &transfer);
+
+  /**
+   * @brief The transfer failed with the error
+   */
+  void failed(const models::Transfer &transfer, int error);
+
+  /**
+   * @brief The transfer was dropped before the copy
+   */
+  void skipped(const models::Transfer &transfer);
+
+  /**
+   * @brief Transfers that were queued or copying
+   */
+  QList<models::Transfer> pending() const;
+
+  /**
+   * @brief Transfers that failed with their error
+   */
+  QList<QPair<models::Transfer, int>> failures() const;
+
+  /**
+   * @brief Instance of the journal
+   */
+  static Journal &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
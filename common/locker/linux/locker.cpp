@@ -0,0 +1,151 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "locker.hpp"
+
+#ifdef __linux__
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Map the errno of a failed lock to the error, a conflicting
+ * lock is reported as EAGAIN or EACCES depending on the kernel
+ */
+int Locker::errorOf(int error) {
+  switch (error) {
+    case EAGAIN:
+    case EACCES:
+    case EINTR:
+      return Error::RECOVERABLE;
+    default:
+      return Error::UNRECOVERABLE;
+  }
+}
+
+/**
+ * @brief Construct a new ILocker object
+ *
+ * @param file
+ * @param parent
+ */
+Locker::Locker(const QString file, Locker::LockMode mode, Locker::LockType type, QObject *parent)
+  : ILocker(parent), file(file), mode(mode), type(type) {
+  // Do nothing
+}
+
+/**
+ * @brief Destroy the ILocker object
+ */
+Locker::~Locker() {
+  this->unlock();
+}
+
+/**
+ * @brief Try to lock a file, the OFD lock belongs to the open file so
+ * it is not lost when another descriptor of the process is closed
+ */
+int Locker::tryLock() {
+  PULLDOG_TRACE_SPAN("Locker::tryLock");
+
+  if (this->isLocked()) {
+    return fd;
+  }
+
+  auto name  = QFile::encodeName(file);
+  auto flags = type == LockType::WRITE ? O_RDWR | O_CREAT : O_RDONLY;
+
+  if ((fd = ::open(name.constData(), flags | O_CLOEXEC, 0644)) < 0) {
+    return errno == EINTR ? Error::RECOVERABLE : Error::UNRECOVERABLE;
+  }
+
+  // cooperative writers hold a write lock while writing
+  struct flock lock = {};
+  lock.l_type   = type == LockType::WRITE ? F_WRLCK : F_RDLCK;
+  lock.l_whence = SEEK_SET;
+
+  if (::fcntl(fd, F_OFD_SETLK, &lock) != 0) {
+    auto error = errno;
+    this->unlock();
+    return errorOf(error);
+  }
+
+  // writing starts from an empty file like CREATE_ALWAYS
+  if (type == LockType::WRITE && ::ftruncate(fd, 0) != 0) {
+    this->unlock();
+    return Error::UNRECOVERABLE;
+  }
+
+  return fd;
+}
+
+/**
+ * @brief Lock a file, instead of sleeping between the attempts it
+ * waits for the writer to close the file, an OFD unlock raises no
+ * event so the wait is bounded by the poll interval
+ */
+int Locker::lock(MSec timeout) {
+  // if file not exists, return error
+  if (!QFile::exists(file) && mode == LockMode::SHARE) {
+    return Error::UNRECOVERABLE;
+  }
+
+  auto watcher = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  auto events  = IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF;
+
+  if (watcher >= 0) {
+    ::inotify_add_watch(watcher, QFile::encodeName(file).constData(), events);
+  }
+
+  DEFER([watcher] { if (watcher >= 0) ::close(watcher); });
+
+  QDeadlineTimer timer(timeout);
+  alignas(struct inotify_event) char buffer[4096];
+
+  while (true) {
+    auto result = this->tryLock();
+
+    if (result != Error::RECOVERABLE) {
+      return result;
+    }
+
+    if (timer.hasExpired()) {
+      return Error::UNRECOVERABLE;
+    }
+
+    auto wait = std::min<qint64>(timer.remainingTime() < 0 ? pollInterval : timer.remainingTime(), pollInterval);
+
+    if (watcher < 0) {
+      ::poll(nullptr, 0, wait);
+      continue;
+    }
+
+    struct pollfd pfd = {watcher, POLLIN, 0};
+
+    // drain the events, any of them is worth another attempt
+    if (::poll(&pfd, 1, wait) > 0) {
+      while (::read(watcher, buffer, sizeof(buffer)) > 0) {
+        continue;
+      }
+    }
+  }
+}
+
+/**
+ * @brief is locked
+ */
+bool Locker::isLocked() const {
+  return fd >= 0;
+}
+
+/**
+ * @brief Unlock a file, closing the descriptor drops the OFD lock
+ * so a waiting writer is released at once
+ */
+void Locker::unlock() {
+  if (this->isLocked()) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
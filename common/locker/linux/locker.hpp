@@ -0,0 +1,98 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+#ifdef __linux__
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QObject>
+#include <QDir>
+#include <QDeadlineTimer>
+#include <QFile>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#include "common/locker/ilocker.hpp"
+#include "common/trace/trace.hpp"
+#include "utility/deferred/deferred.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Locker built from an OFD lock that honors cooperative writers,
+ * waiting for a writer is driven by inotify
+ */
+class Locker : public ILocker {
+ private:
+  Q_DISABLE_COPY(Locker)
+
+ private:
+  using MSec = std::chrono::milliseconds;
+
+ private:
+  static inline const qint64 pollInterval = 1000;  // OFD unlocks raise no event
+
+ private:
+  int fd = -1;
+  LockMode mode;
+  LockType type;
+  QString file;
+
+ private: // Just for qt
+  Q_OBJECT
+
+ private:
+  /**
+   * @brief Map the errno of a failed attempt to the error
+   */
+  static int errorOf(int error);
+
+ public:
+  /**
+   * @brief Construct a new ILocker object
+   */
+  Locker(
+    const QString,
+    LockMode mode = LockMode::SHARE,
+    LockType type = LockType::READ,
+    QObject *parent = nullptr
+  );
+
+  /**
+   * @brief Destroy the ILocker object
+   */
+  ~Locker();
+
+  /**
+   * @brief is locked
+   */
+  bool isLocked() const override;
+
+  /**
+   * @brief Try to lock a file
+   */
+  int tryLock() override;
+
+  /**
+   * @brief Lock a file
+   *
+   * @param file
+   */
+  int lock(MSec timeout = MSec::max()) override;
+
+  /**
+   * @brief Unlock a file
+   *
+   * @param file
+   */
+  void unlock() override;
+};
+}  // namespace srilakshmikanthanp::pulldog::common
+#endif  // __linux__
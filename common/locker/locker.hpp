@@ -9,3 +9,7 @@
 #ifdef _WIN32
 #include "win/locker.hpp"
 #endif
+
+#ifdef __linux__
+#include "linux/locker.hpp"
+#endif
@@ -5,6 +5,7 @@
 
 #include "locker.hpp"
 
+#ifdef _WIN32
 namespace srilakshmikanthanp::pulldog::common {
 /**
  * @brief Construct a new ILocker object
@@ -25,6 +26,8 @@ Locker::~Locker() {
 }
 
 int Locker::tryLock() {
+  PULLDOG_TRACE_SPAN("Locker::tryLock");
+
   auto shareMode = FILE_SHARE_READ;
   auto openMode = OPEN_EXISTING;
 
@@ -104,3 +107,4 @@ void Locker::unlock() {
   }
 }
 }  // namespace srilakshmikanthanp::pulldog::common
+#endif  // _WIN32
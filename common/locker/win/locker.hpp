@@ -18,6 +18,7 @@
 #include <chrono>
 
 #include "common/locker/ilocker.hpp"
+#include "common/trace/trace.hpp"
 
 namespace srilakshmikanthanp::pulldog::common {
 class Locker : public ILocker {
@@ -0,0 +1,161 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "exporter.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Answer the request on the socket once the head of it is in,
+ * the request is consumed and the socket answered only once, the response
+ * is written and the connection closed like HTTP/1.0
+ */
+void Exporter::handle(QIODevice *socket) {
+  auto request = socket->peek(requestLimit);
+
+  if (!request.contains("\r\n\r\n") && request.size() < requestLimit) {
+    return;
+  }
+
+  // whatever else arrives is not another request
+  disconnect(socket, &QIODevice::readyRead, this, nullptr);
+  request = socket->read(requestLimit);
+  socket->readAll();
+
+  socket->write(respond(request));
+
+  if (auto tcp = qobject_cast<QTcpSocket *>(socket)) {
+    tcp->disconnectFromHost();
+  } else if (auto local = qobject_cast<QLocalSocket *>(socket)) {
+    local->disconnectFromServer();
+  }
+}
+
+/**
+ * @brief Response to the request, only a GET of the metrics or the
+ * spans is served
+ */
+QByteArray Exporter::respond(const QByteArray &request) {
+  auto line   = request.left(request.indexOf("\r\n")).split(' ');
+  auto method = line.value(0);
+  auto path   = line.value(1);
+
+  QByteArray status = "200 OK";
+  QByteArray type   = "text/plain; version=0.0.4; charset=utf-8";
+  QByteArray body;
+
+  if (method != "GET") {
+    status = "405 Method Not Allowed";
+  } else if (path == "/trace") {
+    type = "application/json";
+    body = Tracer::instance().dump();
+  } else if (path != "/metrics" && path != "/") {
+    status = "404 Not Found";
+  } else {
+    body = Metrics::instance().render().toUtf8();
+  }
+
+  QByteArray response;
+  response += "HTTP/1.0 " + status + "\r\n";
+  response += "Content-Type: " + type + "\r\n";
+  response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+  response += "Connection: close\r\n\r\n";
+  response += body;
+  return response;
+}
+
+/**
+ * @brief Construct a new Exporter object
+ */
+Exporter::Exporter(QObject *parent) : QObject(parent) {
+  // Do nothing
+}
+
+/**
+ * @brief Destroy the Exporter object
+ */
+Exporter::~Exporter() {
+  this->close();
+}
+
+/**
+ * @brief Listen on unix:PATH, HOST:PORT or PORT of the loopback, an
+ * empty address stops listening, a host that isn't loopback is refused
+ * since the metrics name the watched folders
+ */
+bool Exporter::listen(const QString &address) {
+  this->close();
+
+  if (address.isEmpty()) {
+    return true;
+  }
+
+  // unix domain socket
+  if (address.startsWith(unixPrefix)) {
+    auto path = address.mid(QString(unixPrefix).size());
+    localServer = new QLocalServer(this);
+    localServer->setSocketOptions(QLocalServer::UserAccessOption);
+    QLocalServer::removeServer(path);
+
+    if (!localServer->listen(path)) {
+      emit onError(QString("Metrics can't listen on %1: %2").arg(address, localServer->errorString()));
+      this->close();
+      return false;
+    }
+
+    connect(localServer, &QLocalServer::newConnection, this, [this] {
+      while (auto socket = localServer->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [=] { this->handle(socket); });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+      }
+    });
+
+    return true;
+  }
+
+  // loopback port
+  auto separator = address.lastIndexOf(':');
+  auto host = separator < 0 ? QHostAddress(QHostAddress::LocalHost) : QHostAddress(address.left(separator).remove('[').remove(']'));
+  auto port = address.mid(separator + 1).toUShort();
+
+  if (host.isNull() || !host.isLoopback() || port == 0) {
+    emit onError(QString("Metrics can't listen on %1: not a loopback address").arg(address));
+    return false;
+  }
+
+  tcpServer = new QTcpServer(this);
+
+  if (!tcpServer->listen(host, port)) {
+    emit onError(QString("Metrics can't listen on %1: %2").arg(address, tcpServer->errorString()));
+    this->close();
+    return false;
+  }
+
+  connect(tcpServer, &QTcpServer::newConnection, this, [this] {
+    while (auto socket = tcpServer->nextPendingConnection()) {
+      connect(socket, &QTcpSocket::readyRead, this, [=] { this->handle(socket); });
+      connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+  });
+
+  return true;
+}
+
+/**
+ * @brief Stop listening
+ */
+void Exporter::close() {
+  if (tcpServer) {
+    tcpServer->close();
+    tcpServer->deleteLater();
+    tcpServer = nullptr;
+  }
+
+  if (localServer) {
+    localServer->close();
+    localServer->deleteLater();
+    localServer = nullptr;
+  }
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,81 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QFile>
+#include <QHostAddress>
+#include <QIODevice>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "common/metrics/metrics.hpp"
+#include "common/trace/trace.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Serves the metrics as Prometheus text over HTTP on a loopback
+ * port or a Unix domain socket, a scrape renders the metrics when it
+ * comes so nothing is kept between the scrapes, the spans are served as
+ * Chrome trace events on /trace
+ */
+class Exporter : public QObject {
+ private:
+  Q_DISABLE_COPY(Exporter)
+
+ private:  // Just for qt
+  Q_OBJECT
+
+ private:
+  static inline const qsizetype requestLimit = 8192;  // bytes of a request
+  static inline const char *unixPrefix = "unix:";
+
+ private:
+  QTcpServer *tcpServer     = nullptr;
+  QLocalServer *localServer = nullptr;
+
+ private:
+  /**
+   * @brief Answer the request on the socket once it is complete
+   */
+  void handle(QIODevice *socket);
+
+  /**
+   * @brief Response to the request
+   */
+  static QByteArray respond(const QByteArray &request);
+
+ signals:
+  void onError(const QString &error);
+
+ public:
+
+  /**
+   * @brief Construct a new Exporter object
+   */
+  Exporter(QObject *parent = nullptr);
+
+  /**
+   * @brief Destroy the Exporter object
+   */
+  virtual ~Exporter();
+
+  /**
+   * @brief Listen on unix:PATH, HOST:PORT or PORT of the loopback, an
+   * empty address stops listening
+   */
+  bool listen(const QString &address);
+
+  /**
+   * @brief Stop listening
+   */
+  void close();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
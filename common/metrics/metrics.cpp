@@ -0,0 +1,319 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "metrics.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Bucket of the value, the octave picks the pair of buckets
+ * and the bit below the leading one picks the half of it, a value
+ * beyond the last bucket is buckets
+ */
+int Metrics::Histogram::bucketOf(qint64 value) {
+  auto v      = static_cast<quint64>(std::max<qint64>(value, 2));
+  int octave  = 63 - qCountLeadingZeroBits(v);
+  int half    = static_cast<int>((v >> (octave - 1)) & 1);
+  return std::min((octave - 1) * 2 + half, buckets);
+}
+
+/**
+ * @brief Largest value of the bucket
+ */
+qint64 Metrics::Histogram::upperOf(int bucket) {
+  auto octave = bucket / 2 + 1;
+  auto half   = bucket % 2;
+  return (static_cast<qint64>(3 + half) << (octave - 1)) - 1;
+}
+
+/**
+ * @brief Record the value without a lock
+ */
+void Metrics::Histogram::record(qint64 value) {
+  auto bucket = bucketOf(value);
+  (bucket < buckets ? counts[bucket] : overflow).fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(static_cast<quint64>(std::max<qint64>(value, 0)), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Write the histogram as Prometheus text in seconds, the count
+ * is summed from the buckets so it matches them while they are recorded,
+ * a value beyond the last bucket is only in +Inf
+ */
+void Metrics::Histogram::render(QTextStream &out, const QString &name) const {
+  quint64 cumulative = 0;
+
+  for (int i = 0; i < buckets; ++i) {
+    cumulative += counts[i].load(std::memory_order_relaxed);
+    auto le = QString::number(static_cast<double>(upperOf(i)) / 1e6, 'g', 10);
+    out << name << "_bucket{le=\"" << le << "\"} " << cumulative << "\n";
+  }
+
+  auto total = static_cast<double>(sum.load(std::memory_order_relaxed)) / 1e6;
+  cumulative += overflow.load(std::memory_order_relaxed);
+
+  out << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+  out << name << "_sum " << QString::number(total, 'g', 12) << "\n";
+  out << name << "_count " << cumulative << "\n";
+}
+
+/**
+ * @brief Construct a new Metrics object
+ */
+Metrics::Metrics() {
+  clock.start();
+}
+
+/**
+ * @brief Escape the value of a label
+ */
+QString Metrics::escape(QString value) {
+  return value.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+}
+
+/**
+ * @brief Write the help and the type of a metric
+ */
+void Metrics::header(QTextStream &out, const QString &name, const char *type, const char *help) {
+  out << "# HELP " << name << " " << help << "\n";
+  out << "# TYPE " << name << " " << type << "\n";
+}
+
+/**
+ * @brief Microseconds on the clock, never 0
+ */
+qint64 Metrics::now() const {
+  return clock.nsecsElapsed() / 1000 + 1;
+}
+
+/**
+ * @brief Forget the transfer and record its latencies to the end, a
+ * failed transfer has no latency to the commit
+ */
+void Metrics::finish(const models::Transfer &transfer, bool committed) {
+  QMutexLocker locker(&stampMutex);
+  auto stamp = stamps.take(transfer);
+  locker.unlock();
+
+  if (!committed) {
+    return;
+  }
+
+  auto time = this->now();
+
+  if (stamp.started) {
+    this->record(Latency::START_COMMIT, time - stamp.started);
+  }
+
+  if (stamp.detected) {
+    this->record(Latency::DETECT_COMMIT, time - stamp.detected);
+  }
+}
+
+/**
+ * @brief Add to the counter
+ */
+void Metrics::count(Counter counter, quint64 value) {
+  values[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Record the latency in microseconds
+ */
+void Metrics::record(Latency latency, qint64 value) {
+  histograms[static_cast<size_t>(latency)].record(value);
+}
+
+/**
+ * @brief A change of the source of the transfer was seen, a change of
+ * a transfer in the pipeline doesn't restart its clock, the stamps are
+ * bounded like the queues so transfers that never finish can't pile up
+ */
+void Metrics::detected(const models::Transfer &transfer) {
+  QMutexLocker locker(&stampMutex);
+
+  if (stamps.contains(transfer) || stamps.size() >= stampCapacity) {
+    return;
+  }
+
+  stamps[transfer].detected = this->now();
+}
+
+/**
+ * @brief The writer of the source is done
+ */
+void Metrics::ready(const models::Transfer &transfer) {
+  QMutexLocker locker(&stampMutex);
+  auto stamp = stamps.find(transfer);
+
+  if (stamp == stamps.end()) {
+    return;
+  }
+
+  stamp->ready = this->now();
+
+  if (stamp->detected) {
+    this->record(Latency::DETECT_READY, stamp->ready - stamp->detected);
+  }
+}
+
+/**
+ * @brief The copy of the transfer started, a copy restarted after
+ * a cancel keeps the time it first started
+ */
+void Metrics::started(const models::Transfer &transfer) {
+  QMutexLocker locker(&stampMutex);
+  auto stamp = stamps.find(transfer);
+
+  if (stamp == stamps.end() || stamp->started) {
+    return;
+  }
+
+  stamp->started = this->now();
+
+  if (stamp->ready) {
+    this->record(Latency::READY_START, stamp->started - stamp->ready);
+  }
+}
+
+/**
+ * @brief The transfer was committed
+ */
+void Metrics::committed(const models::Transfer &transfer) {
+  this->count(Counter::COMMITTED);
+  this->finish(transfer, true);
+}
+
+/**
+ * @brief The transfer failed
+ */
+void Metrics::failed(const models::Transfer &transfer) {
+  this->count(Counter::FAILED);
+  this->finish(transfer, false);
+}
+
+/**
+ * @brief The transfer was given up without a copy, it only
+ * gives back its stamps so they can't fill up the map
+ */
+void Metrics::skipped(const models::Transfer &transfer) {
+  this->finish(transfer, false);
+}
+
+/**
+ * @brief A root was scanned
+ */
+void Metrics::scanned(const QString &root, qint64 duration, qint64 files) {
+  QMutexLocker locker(&scanMutex);
+  auto &scan    = scans[root];
+  scan.duration = duration;
+  scan.files    = files;
+  scan.scans++;
+}
+
+/**
+ * @brief Forget the scans of a root
+ */
+void Metrics::removeRoot(const QString &root) {
+  QMutexLocker locker(&scanMutex);
+  scans.remove(root);
+}
+
+/**
+ * @brief The metrics as Prometheus text
+ */
+QString Metrics::render() const {
+  QString text;
+  QTextStream out(&text);
+
+  // counters of the stages
+  for (size_t i = 0; i < counters; ++i) {
+    header(out, counterNames[i], "counter", "Events of the pipeline.");
+    out << counterNames[i] << " " << values[i].load(std::memory_order_relaxed) << "\n";
+  }
+
+  // latencies between the stages
+  for (size_t i = 0; i < latencies; ++i) {
+    header(out, latencyNames[i], "histogram", "Latency between the stages of a transfer.");
+    histograms[i].render(out, latencyNames[i]);
+  }
+
+  // queues between the stages
+  auto occupancy = Budget::instance().getOccupancy();
+
+  header(out, "pulldog_queue_items", "gauge", "Items in the queue between the stages.");
+  for (const auto &queue : occupancy) {
+    out << "pulldog_queue_items{queue=\"" << queue.name << "\"} " << queue.items << "\n";
+  }
+
+  header(out, "pulldog_queue_bytes", "gauge", "Bytes held by the queue between the stages.");
+  for (const auto &queue : occupancy) {
+    out << "pulldog_queue_bytes{queue=\"" << queue.name << "\"} " << queue.bytes << "\n";
+  }
+
+  header(out, "pulldog_queue_limit", "gauge", "Items the queue takes.");
+  for (const auto &queue : occupancy) {
+    out << "pulldog_queue_limit{queue=\"" << queue.name << "\"} " << queue.limit << "\n";
+  }
+
+  // transfers waiting and copying
+  auto &budget = Budget::instance();
+
+  header(out, "pulldog_transfers_pending", "gauge", "Transfers waiting for the writer or a retry.");
+  out << "pulldog_transfers_pending " << budget.items(Budget::Queue::WATCH) + budget.items(Budget::Queue::WORK) << "\n";
+
+  header(out, "pulldog_transfers_in_flight", "gauge", "Transfers queued or copying.");
+  out << "pulldog_transfers_in_flight " << budget.items(Budget::Queue::COPY) << "\n";
+
+  // lanes of the scheduler
+  auto lanes = Scheduler::instance().getLanes();
+
+  header(out, "pulldog_lane_throughput_bytes_per_second", "gauge", "Bytes per second of the lane in the last window.");
+  for (const auto &lane : lanes) {
+    auto throughput = lane.history.isEmpty() ? 0 : lane.history.last().throughput;
+    out << "pulldog_lane_throughput_bytes_per_second{source=\"" << lane.key.first << "\",destination=\"" << lane.key.second << "\"} " << throughput << "\n";
+  }
+
+  header(out, "pulldog_lane_limit", "gauge", "Copies the lane runs at once.");
+  for (const auto &lane : lanes) {
+    out << "pulldog_lane_limit{source=\"" << lane.key.first << "\",destination=\"" << lane.key.second << "\"} " << lane.limit << "\n";
+  }
+
+  header(out, "pulldog_lane_running", "gauge", "Copies running in the lane.");
+  for (const auto &lane : lanes) {
+    out << "pulldog_lane_running{source=\"" << lane.key.first << "\",destination=\"" << lane.key.second << "\"} " << lane.running << "\n";
+  }
+
+  // scans of the roots
+  QMutexLocker locker(&scanMutex);
+  auto roots = scans;
+  locker.unlock();
+
+  header(out, "pulldog_scan_duration_seconds", "gauge", "Duration of the last scan of the root.");
+  for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+    out << "pulldog_scan_duration_seconds{root=\"" << escape(it.key()) << "\"} " << static_cast<double>(it->duration) / 1e3 << "\n";
+  }
+
+  header(out, "pulldog_scan_files", "gauge", "Files seen by the last scan of the root.");
+  for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+    out << "pulldog_scan_files{root=\"" << escape(it.key()) << "\"} " << it->files << "\n";
+  }
+
+  header(out, "pulldog_scans_total", "counter", "Scans of the root.");
+  for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+    out << "pulldog_scans_total{root=\"" << escape(it.key()) << "\"} " << it->scans << "\n";
+  }
+
+  out.flush();
+  return text;
+}
+
+/**
+ * @brief Instance of the metrics
+ */
+Metrics &Metrics::instance() {
+  static Metrics instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,237 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "common/budget/budget.hpp"
+#include "common/scheduler/scheduler.hpp"
+#include "models/transfer/transfer.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Metrics of the pipeline rendered as Prometheus text, the counters
+ * and the latency histograms are relaxed atomics so the stages record them
+ * without a lock, the stage stamps of a transfer sit in a map behind a
+ * mutex held only for the lookup, the queues and the lanes are read from
+ * the budget and the scheduler only when the metrics are scraped
+ */
+class Metrics {
+ private:
+  Q_DISABLE_COPY_MOVE(Metrics)
+
+ public:
+  /**
+   * @brief Counters of the pipeline
+   */
+  enum class Counter {
+    LOCK_PROBES,  // probes of the lock of a source
+    LOCK_BUSY,    // probes that found the writer
+    COMMITTED,    // transfers committed
+    FAILED,       // transfers failed
+    SPARSE,       // copies that kept the holes of the source
+    HOLES,        // bytes of holes not sent over the wire
+    THROTTLED,    // ms copies waited on the bandwidth governor
+  };
+
+  /**
+   * @brief Latencies between the stages of a transfer
+   */
+  enum class Latency {
+    DETECT_READY,   // change seen to writer done
+    READY_START,    // writer done to copy started
+    START_COMMIT,   // copy started to committed
+    DETECT_COMMIT,  // change seen to committed
+  };
+
+  /**
+   * @brief Log linear histogram of microseconds in the manner of HDR,
+   * every power of two is split in two buckets so a value is off by
+   * at most a quarter whatever its magnitude
+   */
+  class Histogram {
+   public:
+    static inline const int octaves = 36;  // up to ~38 hours
+    static inline const int buckets = octaves * 2;
+
+   private:
+    std::array<std::atomic<quint64>, buckets> counts = {};
+    std::atomic<quint64> overflow = 0;  // beyond the last bucket
+    std::atomic<quint64> sum      = 0;
+
+   public:
+    /**
+     * @brief Bucket of the value, buckets if beyond the last one
+     */
+    static int bucketOf(qint64 value);
+
+    /**
+     * @brief Largest value of the bucket
+     */
+    static qint64 upperOf(int bucket);
+
+    /**
+     * @brief Record the value without a lock
+     */
+    void record(qint64 value);
+
+    /**
+     * @brief Write the histogram as Prometheus text in seconds
+     */
+    void render(QTextStream &out, const QString &name) const;
+  };
+
+ private:
+  // stages a transfer went through, 0 is not yet
+  struct Stamps {
+    qint64 detected = 0;
+    qint64 ready    = 0;
+    qint64 started  = 0;
+  };
+
+  // last scan of a root
+  struct Scan {
+    qint64 duration = 0;  // ms
+    qint64 files    = 0;
+    quint64 scans   = 0;
+  };
+
+ private:
+  static inline const size_t counters  = 7;
+  static inline const size_t latencies = 4;
+  static inline const qsizetype stampCapacity = 1 << 17;  // transfers in the pipeline
+
+ private:
+  static inline const std::array<const char *, counters> counterNames = {
+    "pulldog_lock_probes_total",
+    "pulldog_lock_busy_total",
+    "pulldog_transfers_committed_total",
+    "pulldog_transfers_failed_total",
+    "pulldog_sparse_copies_total",
+    "pulldog_sparse_hole_bytes_total",
+    "pulldog_throttled_milliseconds_total",
+  };
+
+  static inline const std::array<const char *, latencies> latencyNames = {
+    "pulldog_detect_to_ready_seconds",
+    "pulldog_ready_to_start_seconds",
+    "pulldog_start_to_commit_seconds",
+    "pulldog_detect_to_commit_seconds",
+  };
+
+ private:
+  std::array<std::atomic<quint64>, counters> values = {};
+  std::array<Histogram, latencies> histograms;
+  QMap<models::Transfer, Stamps> stamps;  // behind the stamp mutex
+  QMap<QString, Scan> scans;
+  QElapsedTimer clock;
+  mutable QMutex stampMutex;
+  mutable QMutex scanMutex;
+
+ private:
+  /**
+   * @brief Construct a new Metrics object
+   */
+  Metrics();
+
+  /**
+   * @brief Escape the value of a label
+   */
+  static QString escape(QString value);
+
+  /**
+   * @brief Write the help and the type of a metric
+   */
+  static void header(QTextStream &out, const QString &name, const char *type, const char *help);
+
+  /**
+   * @brief Microseconds on the clock, never 0
+   */
+  qint64 now() const;
+
+  /**
+   * @brief Forget the transfer and record its latencies to the end
+   */
+  void finish(const models::Transfer &transfer, bool committed);
+
+ public:
+  /**
+   * @brief Destroy the Metrics object
+   */
+  ~Metrics() = default;
+
+  /**
+   * @brief Add to the counter
+   */
+  void count(Counter counter, quint64 value = 1);
+
+  /**
+   * @brief Record the latency in microseconds
+   */
+  void record(Latency latency, qint64 value);
+
+  /**
+   * @brief A change of the source of the transfer was seen
+   */
+  void detected(const models::Transfer &transfer);
+
+  /**
+   * @brief The writer of the source is done
+   */
+  void ready(const models::Transfer &transfer);
+
+  /**
+   * @brief The copy of the transfer started
+   */
+  void started(const models::Transfer &transfer);
+
+  /**
+   * @brief The transfer was committed
+   */
+  void committed(const models::Transfer &transfer);
+
+  /**
+   * @brief The transfer failed
+   */
+  void failed(const models::Transfer &transfer);
+
+  /**
+   * @brief The transfer was given up without a copy
+   */
+  void skipped(const models::Transfer &transfer);
+
+  /**
+   * @brief A root was scanned
+   */
+  void scanned(const QString &root, qint64 duration, qint64 files);
+
+  /**
+   * @brief Forget the scans of a root
+   */
+  void removeRoot(const QString &root);
+
+  /**
+   * @brief The metrics as Prometheus text
+   */
+  QString render() const;
+
+  /**
+   * @brief Instance of the metrics
+   */
+  static Metrics &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
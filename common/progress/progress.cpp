@@ -0,0 +1,78 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "progress.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Construct a new Progress object
+ */
+Progress::Progress(qint64 interval) : interval(interval) {
+  clock.start();
+  sampled = -interval;
+}
+
+/**
+ * @brief Set the total number of bytes
+ */
+void Progress::setTotal(qint64 total) {
+  this->total.store(total, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get the total number of bytes
+ */
+qint64 Progress::getTotal() const {
+  return total.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set the number of bytes done
+ */
+void Progress::setDone(qint64 done) {
+  this->done.store(done, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Add to the number of bytes done
+ */
+void Progress::add(qint64 bytes) {
+  done.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get the number of bytes done
+ */
+qint64 Progress::getDone() const {
+  return done.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Progress in percent
+ */
+double Progress::percent() const {
+  auto size = getTotal();
+  return size > 0 ? (static_cast<double>(getDone()) / size) * 100 : 100;
+}
+
+/**
+ * @brief true at most once per interval and always on completion,
+ * concurrent samplers race on the timestamp and only one of them wins
+ */
+bool Progress::isDue() {
+  auto now  = clock.elapsed();
+  auto last = sampled.load(std::memory_order_relaxed);
+
+  if (getDone() >= getTotal()) {
+    return true;
+  }
+
+  if (now - last < interval) {
+    return false;
+  }
+
+  return sampled.compare_exchange_strong(last, now, std::memory_order_relaxed);
+}
+}  // namespace srilakshmikanthanp::pulldog::common
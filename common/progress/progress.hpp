@@ -0,0 +1,72 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+#include <atomic>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Lock free progress counter of a transfer, the copy loop only
+ * stores the byte count and the progress is sampled at a bounded rate
+ * so a fast copy doesn't flood the event queue with signals
+ */
+class Progress {
+ private:
+  Q_DISABLE_COPY_MOVE(Progress)
+
+ private:
+  std::atomic<qint64> done    = 0;
+  std::atomic<qint64> total   = 0;
+  std::atomic<qint64> sampled = 0;  // milliseconds of the last sample
+  const qint64 interval;
+  QElapsedTimer clock;
+
+ public:
+
+  /**
+   * @brief Construct a new Progress object
+   */
+  Progress(qint64 interval = 100);
+
+  /**
+   * @brief Set the total number of bytes
+   */
+  void setTotal(qint64 total);
+
+  /**
+   * @brief Get the total number of bytes
+   */
+  qint64 getTotal() const;
+
+  /**
+   * @brief Set the number of bytes done
+   */
+  void setDone(qint64 done);
+
+  /**
+   * @brief Add to the number of bytes done
+   */
+  void add(qint64 bytes);
+
+  /**
+   * @brief Get the number of bytes done
+   */
+  qint64 getDone() const;
+
+  /**
+   * @brief Progress in percent
+   */
+  double percent() const;
+
+  /**
+   * @brief true at most once per interval and always on completion
+   */
+  bool isDue();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
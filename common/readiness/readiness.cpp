@@ -0,0 +1,314 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "readiness.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Put the candidate into the slot of its deadline, a deadline
+ * beyond the wheel lands in the last slot and is put back on the visit
+ */
+void Readiness::schedule(const QString &from, Candidate &candidate) {
+  auto wait  = candidate.deadline - clock.elapsed();
+  auto ticks = std::clamp<qint64>((wait + tick - 1) / tick, 1, slots - 1);
+
+  wheel[candidate.slot].remove(from);
+  candidate.slot = (cursor + ticks) % slots;
+  wheel[candidate.slot].insert(from);
+
+  if (!ticker.isActive()) {
+    ticker.start();
+  }
+}
+
+/**
+ * @brief Look at the candidates of the next slot, a file whose size
+ * or modification time changed starts its quiet window over
+ */
+void Readiness::advance() {
+  cursor = (cursor + 1) % slots;
+
+  auto due = std::exchange(wheel[cursor], {});
+  auto now = clock.elapsed();
+
+  for (const auto &from : due) {
+    auto candidate = candidates.find(from);
+
+    if (candidate == candidates.end()) {
+      continue;
+    }
+
+    if (candidate->deadline > now) {
+      this->schedule(from, *candidate);
+      continue;
+    }
+
+    QFileInfo info(from);
+
+    if (!info.exists()) {
+      for (const auto &to : this->drop(from)) {
+        this->skip(models::Transfer(from, to));
+      }
+
+      continue;
+    }
+
+    auto mtime = info.lastModified().toMSecsSinceEpoch();
+
+    if (info.size() == candidate->size && mtime == candidate->mtime) {
+      this->ready(from);
+      continue;
+    }
+
+    candidate->size     = info.size();
+    candidate->mtime    = mtime;
+    candidate->deadline = now + quietWindow;
+    this->schedule(from, *candidate);
+  }
+
+  if (candidates.isEmpty()) {
+    ticker.stop();
+  }
+}
+
+/**
+ * @brief Forget the candidate and emit it as ready, while the queue of
+ * the worker is full the candidate is held for another quiet window
+ */
+void Readiness::ready(const QString &from) {
+  if (Budget::instance().isFull(Budget::Queue::WORK)) {
+    auto candidate = candidates.find(from);
+    candidate->deadline = clock.elapsed() + quietWindow;
+    return this->schedule(from, *candidate);
+  }
+
+  for (const auto &to : this->drop(from)) {
+    this->handOver(models::Transfer(from, to));
+  }
+}
+
+/**
+ * @brief Hand the transfer over to the worker, the worker
+ * accounts it in its own queue
+ */
+void Readiness::handOver(const models::Transfer &transfer) {
+  Budget::instance().release(Budget::Queue::WATCH, Budget::costOf(transfer));
+  emit fileReady(transfer);
+}
+
+/**
+ * @brief Give up the transfer whose source went away, it is journaled
+ * as skipped so it isn't queued again on the next start
+ */
+void Readiness::skip(const models::Transfer &transfer) {
+  Budget::instance().release(Budget::Queue::WATCH, Budget::costOf(transfer));
+  Journal::instance().skipped(transfer);
+  Metrics::instance().skipped(transfer);
+}
+
+/**
+ * @brief Forget the candidate, returns the destinations
+ */
+QStringList Readiness::drop(const QString &from) {
+  auto candidate = candidates.find(from);
+  auto to        = candidate->to;
+
+  wheel[candidate->slot].remove(from);
+  candidates.erase(candidate);
+  this->unwatch(from);
+
+  return to;
+}
+
+/**
+ * @brief Watch the directory of the file for close write, the watch
+ * is shared by the candidates of the directory
+ */
+void Readiness::watch(const QString &from) {
+#ifdef __linux__
+  auto dir = QFileInfo(from).path();
+
+  if (inotify < 0 || users[dir]++ > 0) {
+    return;
+  }
+
+  // a writer that renames a finished file into place is done as well
+  auto events = IN_CLOSE_WRITE | IN_MOVED_TO;
+  auto wd     = ::inotify_add_watch(inotify, QFile::encodeName(dir).constData(), events);
+
+  if (wd >= 0) {
+    watches[dir] = wd;
+    dirs[wd]     = dir;
+  }
+#endif
+}
+
+/**
+ * @brief Stop watching the directory of the file if unused
+ */
+void Readiness::unwatch(const QString &from) {
+#ifdef __linux__
+  auto dir = QFileInfo(from).path();
+
+  if (inotify < 0 || --users[dir] > 0) {
+    return;
+  }
+
+  users.remove(dir);
+
+  if (watches.contains(dir)) {
+    auto wd = watches.take(dir);
+    dirs.remove(wd);
+    ::inotify_rm_watch(inotify, wd);
+  }
+#endif
+}
+
+/**
+ * @brief Read the pending close write events, a file closed by its
+ * writer is ready without waiting for the quiet window
+ */
+void Readiness::readEvents() {
+#ifdef __linux__
+  alignas(struct inotify_event) char buffer[4096];
+  ssize_t length;
+
+  while ((length = ::read(inotify, buffer, sizeof(buffer))) > 0) {
+    for (char *ptr = buffer; ptr < buffer + length;) {
+      auto event = reinterpret_cast<const struct inotify_event *>(ptr);
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      // the directory is gone, the candidates fall back to the wheel
+      if (event->mask & IN_IGNORED) {
+        watches.remove(dirs.take(event->wd));
+        continue;
+      }
+
+      if (event->len == 0 || !dirs.contains(event->wd)) {
+        continue;
+      }
+
+      auto from = QDir(dirs[event->wd]).filePath(QFile::decodeName(event->name));
+
+      if (candidates.contains(from)) {
+        this->ready(from);
+      }
+    }
+  }
+
+  if (candidates.isEmpty()) {
+    ticker.stop();
+  }
+#endif
+}
+
+/**
+ * @brief Construct a new Readiness object
+ */
+Readiness::Readiness(QObject *parent) : QObject(parent), wheel(slots) {
+  // the ticker only runs while there are candidates
+  ticker.setParent(this);
+  ticker.setInterval(tick);
+
+  connect(
+    &ticker, &QTimer::timeout, this, &Readiness::advance
+  );
+
+#ifdef __linux__
+  // without inotify the quiet window is all we have
+  if ((inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) >= 0) {
+    notifier = new QSocketNotifier(inotify, QSocketNotifier::Read, this);
+    connect(
+      notifier, &QSocketNotifier::activated, this, &Readiness::readEvents
+    );
+  }
+#endif
+
+  clock.start();
+}
+
+/**
+ * @brief Destroy the Readiness object
+ */
+Readiness::~Readiness() {
+#ifdef __linux__
+  delete notifier;
+
+  if (inotify >= 0) {
+    ::close(inotify);
+  }
+#endif
+}
+
+/**
+ * @brief Get the quiet window in milliseconds
+ */
+qint64 Readiness::getQuietWindow() const {
+  return quietWindow;
+}
+
+/**
+ * @brief Set the quiet window in milliseconds
+ */
+void Readiness::setQuietWindow(qint64 window) {
+  quietWindow = std::max<qint64>(window, 0);
+}
+
+/**
+ * @brief Number of files waiting to become ready
+ */
+qsizetype Readiness::pending() const {
+  return candidates.size();
+}
+
+/**
+ * @brief Track the file until it is ready, a file whose modification
+ * time is already older than the quiet window is ready at once
+ */
+void Readiness::track(const models::Transfer &transfer) {
+  auto from = transfer.getFrom();
+  auto info = QFileInfo(from);
+
+  // the source went away before it was copied
+  if (!info.exists()) {
+    return this->skip(transfer);
+  }
+
+  // nothing to wait for, the worker settles the directory
+  if (info.isDir()) {
+    return this->handOver(transfer);
+  }
+
+  auto mtime = info.lastModified().toMSecsSinceEpoch();
+  auto now   = clock.elapsed();
+  auto quiet = QDateTime::currentMSecsSinceEpoch() - mtime >= quietWindow;
+
+  // another update or another destination of a file that is tracked
+  if (auto candidate = candidates.find(from); candidate != candidates.end()) {
+    // the new item of the watch queue takes the place of the old one
+    if (candidate->to.contains(transfer.getTo())) {
+      Budget::instance().release(Budget::Queue::WATCH, Budget::costOf(transfer));
+    } else {
+      candidate->to.append(transfer.getTo());
+    }
+
+    candidate->size     = info.size();
+    candidate->mtime    = mtime;
+    candidate->deadline = now + quietWindow;
+    return;
+  }
+
+  if (quiet && !Budget::instance().isFull(Budget::Queue::WORK)) {
+    return this->handOver(transfer);
+  }
+
+  auto candidate = candidates.insert(
+    from, Candidate{{transfer.getTo()}, info.size(), mtime, now + quietWindow}
+  );
+
+  this->watch(from);
+  this->schedule(from, *candidate);
+}
+}  // namespace srilakshmikanthanp::pulldog::common
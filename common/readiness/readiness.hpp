@@ -0,0 +1,164 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "common/budget/budget.hpp"
+#include "common/journal/journal.hpp"
+#include "common/metrics/metrics.hpp"
+#include "models/transfer/transfer.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Stage in front of the worker that decides when the writer of a
+ * file is done, a file is ready on close write where the kernel reports
+ * it or once its size and modification time stayed the same for a quiet
+ * window, the candidates sit in a timer wheel so a tick only looks at the
+ * files that are due
+ */
+class Readiness : public QObject {
+ private:
+  Q_DISABLE_COPY(Readiness)
+
+ private:  // Just for qt
+  Q_OBJECT
+
+ private:
+  // a file that is still being written
+  struct Candidate {
+    QStringList to;  // a destination of every root it goes to
+    qint64 size     = -1;
+    qint64 mtime    = 0;  // milliseconds since epoch
+    qint64 deadline = 0;  // milliseconds on the clock
+    int slot        = 0;
+  };
+
+ private:
+  static inline const int slots   = 64;
+  static inline const qint64 tick = 250;  // ms per slot
+
+ private:
+  QHash<QString, Candidate> candidates;  // keyed by the source
+  QVector<QSet<QString>> wheel;
+  std::atomic<qint64> quietWindow = 2000;
+  QElapsedTimer clock;
+  QTimer ticker;
+  int cursor = 0;
+
+#ifdef __linux__
+ private:
+  QHash<QString, int> watches;  // watch of a directory
+  QHash<int, QString> dirs;     // directory of a watch
+  QHash<QString, int> users;    // candidates in a directory
+  QSocketNotifier *notifier = nullptr;
+  int inotify = -1;
+#endif
+
+ signals:
+  void fileReady(const models::Transfer &transfer);
+
+ private:
+  /**
+   * @brief Put the candidate into the slot of its deadline
+   */
+  void schedule(const QString &from, Candidate &candidate);
+
+  /**
+   * @brief Look at the candidates of the next slot
+   */
+  void advance();
+
+  /**
+   * @brief Forget the candidate and emit it as ready
+   */
+  void ready(const QString &from);
+
+  /**
+   * @brief Hand the transfer over to the worker
+   */
+  void handOver(const models::Transfer &transfer);
+
+  /**
+   * @brief Give up the transfer whose source went away
+   */
+  void skip(const models::Transfer &transfer);
+
+  /**
+   * @brief Forget the candidate, returns the destinations
+   */
+  QStringList drop(const QString &from);
+
+  /**
+   * @brief Watch the directory of the file for close write
+   */
+  void watch(const QString &from);
+
+  /**
+   * @brief Stop watching the directory of the file if unused
+   */
+  void unwatch(const QString &from);
+
+  /**
+   * @brief Read the pending close write events
+   */
+  void readEvents();
+
+ public:
+  /**
+   * @brief Construct a new Readiness object
+   */
+  Readiness(QObject *parent = nullptr);
+
+  /**
+   * @brief Destroy the Readiness object
+   */
+  ~Readiness();
+
+  /**
+   * @brief Get the quiet window in milliseconds
+   */
+  qint64 getQuietWindow() const;
+
+  /**
+   * @brief Set the quiet window in milliseconds
+   */
+  void setQuietWindow(qint64 window);
+
+  /**
+   * @brief Number of files waiting to become ready
+   */
+  qsizetype pending() const;
+
+  /**
+   * @brief Track the file until it is ready, a file that is already
+   * tracked has its quiet window started over, the transfer comes with
+   * an item of the watch queue of the budget, the destinations of a
+   * file are tracked together so they become ready together
+   */
+  void track(const models::Transfer &transfer);
+};
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,107 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Bounded lock free ring of records for many producers and one
+ * consumer, every cell carries a sequence that tells whose turn it is so
+ * a producer claims a cell with a single compare and swap and never
+ * waits on another one, a full ring refuses the record
+ */
+template <typename T, size_t Capacity>
+class Ring {
+ private:
+  Q_DISABLE_COPY_MOVE(Ring)
+
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+ private:
+  // a record and the turn of the cell
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+ private:
+  static inline const size_t mask = Capacity - 1;
+
+ private:
+  std::unique_ptr<Cell[]> cells;
+  alignas(64) std::atomic<size_t> head = 0;  // next to push
+  alignas(64) std::atomic<size_t> tail = 0;  // next to pop
+
+ public:
+  /**
+   * @brief Construct a new Ring object
+   */
+  Ring() : cells(new Cell[Capacity]) {
+    for (size_t i = 0; i < Capacity; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Push the record, false if the ring is full
+   */
+  bool push(T value) {
+    auto position = head.load(std::memory_order_relaxed);
+
+    while (true) {
+      auto &cell = cells[position & mask];
+      auto turn  = static_cast<std::ptrdiff_t>(cell.sequence.load(std::memory_order_acquire) - position);
+
+      if (turn < 0) {
+        return false;
+      }
+
+      if (turn > 0) {
+        position = head.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        cell.value = std::move(value);
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @brief Pop the oldest record, false if the ring is empty
+   */
+  bool pop(T &value) {
+    auto position = tail.load(std::memory_order_relaxed);
+    auto &cell    = cells[position & mask];
+
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+      return false;
+    }
+
+    value = std::move(cell.value);
+    cell.sequence.store(position + Capacity, std::memory_order_release);
+    tail.store(position + 1, std::memory_order_relaxed);
+
+    return true;
+  }
+
+  /**
+   * @brief is the ring empty, exact only for the consumer
+   */
+  bool isEmpty() const {
+    auto position = tail.load(std::memory_order_relaxed);
+    return cells[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+  }
+};
+}  // namespace srilakshmikanthanp::pulldog::common
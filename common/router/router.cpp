@@ -0,0 +1,166 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "router.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Serialize as from=P;glob=G;to=T
+ */
+QString Router::Route::toString() const {
+  return QString("from=%1;glob=%2;to=%3").arg(prefix, glob, target);
+}
+
+/**
+ * @brief Parse from from=P;glob=G;to=T, a missing glob matches all
+ */
+Router::Route Router::Route::fromString(const QString &route) {
+  Route result;
+
+  for (const auto &field : route.split(';', Qt::SkipEmptyParts)) {
+    auto key   = field.section('=', 0, 0).trimmed();
+    auto value = field.section('=', 1).trimmed();
+
+    if (key == "from") {
+      result.prefix = value;
+    } else if (key == "glob") {
+      result.glob = value;
+    } else if (key == "to") {
+      result.target = value;
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @brief Components of the path
+ */
+QStringList Router::componentsOf(const QString &path) {
+  return QDir::cleanPath(QDir::fromNativeSeparators(path)).split('/', Qt::SkipEmptyParts);
+}
+
+/**
+ * @brief Best leaf of the node for the path below it, a *.ext glob is
+ * looked up by every dotted tail of the name instead of being tried
+ */
+const Router::Leaf *Router::match(const Node *node, const QStringList &components, qsizetype depth) {
+  const Leaf *best = nullptr;
+  const auto &name = components.last();
+
+  const auto consider = [&](const Leaf &leaf) {
+    if (best && best->order < leaf.order) {
+      return;
+    }
+
+    auto subject = leaf.path ? components.mid(depth).join('/') : name;
+
+    if (leaf.glob.match(subject).hasMatch()) {
+      best = &leaf;
+    }
+  };
+
+  for (auto dot = name.indexOf('.'); dot >= 0 && !node->suffixes.isEmpty(); dot = name.indexOf('.', dot + 1)) {
+    if (auto bucket = node->suffixes.constFind(name.mid(dot + 1).toLower()); bucket != node->suffixes.cend()) {
+      for (const auto &leaf : *bucket) {
+        if (!best || leaf.order < best->order) best = &leaf;
+      }
+    }
+  }
+
+  for (const auto &leaf : node->leaves) {
+    consider(leaf);
+  }
+
+  return best;
+}
+
+/**
+ * @brief Construct a new Router object
+ */
+Router::Router() : root(std::make_shared<Node>()) {
+  // Do nothing
+}
+
+/**
+ * @brief Set the routes and compile them, a lookup that already
+ * runs keeps the trie it started with
+ */
+void Router::setRoutes(const QList<Route> &routes) {
+  static const QRegularExpression suffixGlob(R"(^\*\.([^*?\[\]/]+)$)");
+  auto trie = std::make_shared<Node>();
+
+  for (int order = 0; order < routes.size(); ++order) {
+    const auto &route = routes[order];
+    auto node = trie.get();
+
+    for (const auto &component : componentsOf(route.prefix)) {
+      auto &child = node->children[component];
+
+      if (!child) {
+        child = std::make_shared<Node>();
+      }
+
+      node = child.get();
+    }
+
+    auto glob = route.glob.isEmpty() ? QString("*") : route.glob;
+
+    if (auto suffix = suffixGlob.match(glob); suffix.hasMatch()) {
+      node->suffixes[suffix.captured(1).toLower()].append(Leaf{order, {}, false, route.target});
+      continue;
+    }
+
+    auto regex = QRegularExpression::fromWildcard(glob, Qt::CaseInsensitive);
+    regex.optimize();
+
+    node->leaves.append(Leaf{order, regex, glob.contains('/'), route.target});
+  }
+
+  QMutexLocker locker(&mutex);
+  this->routes = routes;
+  this->root   = trie;
+}
+
+/**
+ * @brief Get the routes
+ */
+QList<Router::Route> Router::getRoutes() const {
+  QMutexLocker locker(&mutex);
+  return routes;
+}
+
+/**
+ * @brief Destination of the source file, the components of the file
+ * are walked once and the deepest node with a matching route wins, the
+ * path below the prefix of the route is kept under its target
+ */
+std::optional<QString> Router::resolve(const QString &file) const {
+  QMutexLocker locker(&mutex);
+  auto trie = root;
+  locker.unlock();
+
+  auto components = componentsOf(file);
+  auto node       = trie.get();
+  const Leaf *best = nullptr;
+  qsizetype depth  = 0;
+
+  for (qsizetype i = 0; node && i < components.size(); ++i) {
+    if (auto leaf = match(node, components, i)) {
+      best  = leaf;
+      depth = i;
+    }
+
+    auto child = node->children.constFind(components[i]);
+    node = child == node->children.cend() ? nullptr : child->get();
+  }
+
+  if (!best) {
+    return std::nullopt;
+  }
+
+  return QDir(best->target).filePath(components.mid(depth).join('/'));
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,113 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <optional>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Routing table from the source to the destination, the routes
+ * are compiled into a trie of the components of their source prefix
+ * with the globs precompiled at the nodes, a lookup walks the components
+ * of the file once and the deepest matching route wins
+ */
+class Router {
+ private:
+  Q_DISABLE_COPY_MOVE(Router)
+
+ public:
+
+  /**
+   * @brief Route that sends the matching files under the prefix to the
+   * target, a glob without a slash matches the file name and one with a
+   * slash the path below the prefix, an empty glob matches all
+   */
+  struct Route {
+    QString prefix;  // source directory
+    QString glob;
+    QString target;  // destination directory
+
+    /**
+     * @brief Serialize as from=P;glob=G;to=T
+     */
+    QString toString() const;
+
+    /**
+     * @brief Parse from from=P;glob=G;to=T
+     */
+    static Route fromString(const QString &route);
+  };
+
+ private:
+  // a route compiled into its node
+  struct Leaf {
+    int order;  // earlier routes win at the same node
+    QRegularExpression glob;
+    bool path;  // the glob matches the path below the prefix
+    QString target;
+  };
+
+  // a component of the prefixes
+  struct Node {
+    QHash<QString, std::shared_ptr<Node>> children;
+    QHash<QString, QList<Leaf>> suffixes;  // *.ext globs by the suffix
+    QList<Leaf> leaves;                    // everything else
+  };
+
+ private:
+  QList<Route> routes;
+  std::shared_ptr<const Node> root;
+  mutable QMutex mutex;
+
+ private:
+  /**
+   * @brief Components of the path
+   */
+  static QStringList componentsOf(const QString &path);
+
+  /**
+   * @brief Best leaf of the node for the path below it
+   */
+  static const Leaf *match(const Node *node, const QStringList &components, qsizetype depth);
+
+ public:
+  /**
+   * @brief Construct a new Router object
+   */
+  Router();
+
+  /**
+   * @brief Destroy the Router object
+   */
+  ~Router() = default;
+
+  /**
+   * @brief Set the routes and compile them
+   */
+  void setRoutes(const QList<Route> &routes);
+
+  /**
+   * @brief Get the routes
+   */
+  QList<Route> getRoutes() const;
+
+  /**
+   * @brief Destination of the source file, none if no route matches
+   */
+  std::optional<QString> resolve(const QString &file) const;
+};
+}  // namespace srilakshmikanthanp::pulldog::common
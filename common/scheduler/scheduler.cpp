@@ -0,0 +1,686 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "scheduler.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief does the file match the rule
+ */
+bool Scheduler::Rule::matches(const QString &file, qint64 size) const {
+  if (!path.isEmpty() && !file.startsWith(path)) {
+    return false;
+  }
+
+  if (!suffixes.isEmpty() && !suffixes.contains(QFileInfo(file).suffix(), Qt::CaseInsensitive)) {
+    return false;
+  }
+
+  if (minSize >= 0 && size < minSize) {
+    return false;
+  }
+
+  if (maxSize >= 0 && size > maxSize) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Serialize as class=N;path=P;ext=a,b;size=min-max
+ */
+QString Scheduler::Rule::toString() const {
+  return QString("class=%1;path=%2;ext=%3;size=%4-%5")
+      .arg(priority)
+      .arg(path)
+      .arg(suffixes.join(','))
+      .arg(minSize)
+      .arg(maxSize);
+}
+
+/**
+ * @brief Parse from class=N;path=P;ext=a,b;size=min-max, missing
+ * fields match everything
+ */
+Scheduler::Rule Scheduler::Rule::fromString(const QString &rule) {
+  Rule result;
+
+  for (const auto &field : rule.split(';', Qt::SkipEmptyParts)) {
+    auto key   = field.section('=', 0, 0).trimmed();
+    auto value = field.section('=', 1).trimmed();
+
+    if (key == "class") {
+      result.priority = value.toInt();
+    } else if (key == "path") {
+      result.path = value;
+    } else if (key == "ext") {
+      result.suffixes = value.split(',', Qt::SkipEmptyParts);
+    } else if (key == "size") {
+      auto bounds = value.split('-');
+      result.minSize = bounds.value(0).isEmpty() ? -1 : bounds.value(0).toLongLong();
+      result.maxSize = bounds.value(1).isEmpty() ? -1 : bounds.value(1).toLongLong();
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @brief Construct a new Scheduler object, the pool is sized for the
+ * sum of the lanes since a copy mostly waits on its devices
+ */
+Scheduler::Scheduler() {
+  pool.setMaxThreadCount(threads);
+  clock.start();
+}
+
+/**
+ * @brief Device of the path or of its closest existing parent, the
+ * destination of a copy mostly doesn't exist yet
+ */
+quint64 Scheduler::deviceOf(const QString &path) {
+  auto current = QDir::cleanPath(path);
+
+#ifdef __linux__
+  struct stat info;
+
+  while (::stat(QFile::encodeName(current).constData(), &info) != 0) {
+    auto parent = QFileInfo(current).path();
+
+    if (parent == current) {
+      return 0;
+    }
+
+    current = parent;
+  }
+
+  return info.st_dev;
+#else
+  while (!QFileInfo::exists(current)) {
+    auto parent = QFileInfo(current).path();
+
+    if (parent == current) {
+      return 0;
+    }
+
+    current = parent;
+  }
+
+  return qHash(QStorageInfo(current).rootPath());
+#endif
+}
+
+/**
+ * @brief Is the error a sign of a struggling device, a missing or a
+ * replaced source is the business of the writer, the codes of the other
+ * platforms aren't told apart so every failure counts there
+ */
+bool Scheduler::isFault(int error) {
+#ifdef __linux__
+  switch (error) {
+    case EIO:
+    case ETIMEDOUT:
+    case EHOSTDOWN:
+    case EHOSTUNREACH:
+    case ENOTCONN:
+    case ECONNRESET:
+    case ECONNABORTED:
+    case ENETDOWN:
+    case ENETUNREACH:
+    case ENETRESET:
+    case ENOLINK:
+    case EREMOTEIO:
+      return true;
+    default:
+      return false;
+  }
+#else
+  return true;
+#endif
+}
+
+/**
+ * @brief Copies the device takes at once, a spinning disk thrashes with
+ * more than a couple of streams while a share needs many to hide the
+ * latency, devices without a block device behind them are mostly shares
+ */
+int Scheduler::limitOf(quint64 device) {
+#ifdef __linux__
+  if (::major(device) == 0) {
+    return remoteLimit;
+  }
+
+  auto block = QString("/sys/dev/block/%1:%2").arg(::major(device)).arg(::minor(device));
+
+  // a partition has the queue on its disk
+  for (const auto &queue : {"/queue/rotational", "/../queue/rotational"}) {
+    QFile rotational(block + queue);
+
+    if (rotational.open(QIODevice::ReadOnly)) {
+      return rotational.readAll().trimmed() == "1" ? rotationalLimit : solidLimit;
+    }
+  }
+#endif
+
+  return solidLimit;
+}
+
+/**
+ * @brief Class of the file by the rules, falls back to the size
+ */
+int Scheduler::classOf(const QString &file, qint64 size) const {
+  for (const auto &rule : rules) {
+    if (rule.matches(file, size)) {
+      return rule.priority;
+    }
+  }
+
+  if (size < smallSize) {
+    return 0;
+  }
+
+  if (size < bulkSize) {
+    return 1;
+  }
+
+  return 2;
+}
+
+/**
+ * @brief Class of the entry improved by the time it waited
+ * so a bulk copy can't starve behind a stream of small ones
+ */
+int Scheduler::effective(const Entry *entry, qint64 now) const {
+  return entry->priority - static_cast<int>((now - entry->enqueued) / agingInterval);
+}
+
+/**
+ * @brief Entry of the key, needs the lock
+ */
+Scheduler::Entry *Scheduler::find(const void *key) const {
+  for (auto entry : entries) {
+    if (entry->key == key) {
+      return entry;
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * @brief Best waiting entry of a lane with a free slot, the lane of
+ * the thread wins a tie so a thread stays on its devices and only
+ * steals from another lane once its own one has nothing to run
+ */
+Scheduler::Entry *Scheduler::best(const Lane *preferred) const {
+  auto now = clock.elapsed();
+
+  // order of the entry, lower runs first
+  const auto order = [&](const Entry *entry) {
+    return std::make_tuple(
+      effective(entry, now), entry->lane != preferred, entry->remaining
+    );
+  };
+
+  Entry *chosen = nullptr;
+
+  for (auto entry : entries) {
+    if (entry->running) {
+      continue;
+    }
+
+    // a waiting copy means the lane could use more
+    if (entry->lane->running >= entry->lane->limit) {
+      entry->lane->full = true;
+      continue;
+    }
+
+    if (!chosen || order(entry) < order(chosen)) {
+      chosen = entry;
+    }
+  }
+
+  return chosen;
+}
+
+/**
+ * @brief Mark the entry running, an idle lane starts a new window
+ * so the idle time doesn't count against its throughput, needs the lock
+ */
+void Scheduler::occupy(Entry *entry) {
+  auto lane = entry->lane;
+
+  if (lane->running == 0) {
+    lane->window = clock.elapsed();
+    lane->bytes  = 0;
+    lane->busy   = 0;
+    lane->worst  = 0;
+  }
+
+  entry->running = true;
+  lane->full = lane->full || ++lane->running >= lane->limit;
+  running++;
+}
+
+/**
+ * @brief Run the entry and then whatever the thread can take, the
+ * thread goes back to the pool only once no lane has work for it
+ */
+void Scheduler::drain(Entry *entry) {
+  while (entry) {
+    auto runnable = entry->runnable;
+    auto lane     = entry->lane;
+
+    entry->lastYield = clock.nsecsElapsed();
+    current = entry;
+    runnable->run();
+    current = nullptr;
+
+    if (runnable->autoDelete()) {
+      delete runnable;
+    }
+
+    // the tail after the last chunk of a copy that made it
+    if (!entry->failed) {
+      this->account(entry, 0);
+    }
+
+    QMutexLocker locker(&mutex);
+
+    if (entry->preempt) {
+      preempting--;
+    }
+
+    lane->running--;
+    running--;
+    Budget::instance().release(Budget::Queue::COPY, entry->cost);
+    entries.removeOne(entry);
+    delete entry;
+
+    // take the next entry, a paused copy continues on its own thread
+    for (entry = nullptr; running < threads;) {
+      auto next = this->best(lane);
+
+      if (!next) {
+        break;
+      }
+
+      this->occupy(next);
+
+      if (next->paused) {
+        next->paused = false;
+        condition.wakeAll();
+        continue;
+      }
+
+      entry = next;
+      break;
+    }
+
+    this->dispatch();
+  }
+}
+
+/**
+ * @brief Start or resume the best waiting entries while there are
+ * free slots, then ask the least urgent running copy to pause if a
+ * waiting one is more urgent, needs the lock
+ */
+void Scheduler::dispatch() {
+  while (running < threads) {
+    auto entry = this->best();
+
+    if (!entry) {
+      break;
+    }
+
+    this->occupy(entry);
+
+    // resume a paused copy
+    if (entry->paused) {
+      entry->paused = false;
+      condition.wakeAll();
+      continue;
+    }
+
+    pool.start([this, entry]() { this->drain(entry); });
+  }
+
+  this->preempt();
+}
+
+/**
+ * @brief Ask the least urgent copy to pause for the most urgent waiting
+ * one of a lane, within the lane if the lane is full, aging only orders
+ * the waiting ones, a copy is never paused for another of the same class
+ * or the copies would thrash, needs the lock
+ */
+void Scheduler::preempt() {
+  QHash<Lane *, Entry *> urgent;
+
+  for (auto entry : entries) {
+    if (!entry->running && (!urgent.contains(entry->lane) || entry->priority < urgent[entry->lane]->priority)) {
+      urgent[entry->lane] = entry;
+    }
+  }
+
+  for (auto waiting : std::as_const(urgent)) {
+    auto full = waiting->lane->running >= waiting->lane->limit;
+
+    if (!full && running < threads) {
+      continue;
+    }
+
+    Entry *victim = nullptr;
+
+    for (auto entry : entries) {
+      if (!entry->running || entry->preempt || (full && entry->lane != waiting->lane)) {
+        continue;
+      }
+
+      if (!victim || entry->priority > victim->priority) {
+        victim = entry;
+      }
+    }
+
+    if (victim && waiting->priority < victim->priority) {
+      victim->preempt = true;
+      preempting++;
+    }
+  }
+}
+
+/**
+ * @brief Account the chunk of the running entry, only the thread of
+ * the entry writes its fields and the counters of the lane are atomic,
+ * the thread that closes a window adapts the lane under the lock
+ */
+void Scheduler::account(Entry *entry, qint64 remaining) {
+  auto lane  = entry->lane;
+  auto now   = clock.nsecsElapsed();
+  auto chunk = entry->remaining - remaining;
+
+  if (chunk > 0) {
+    auto spent = now - entry->lastYield;
+    auto cost  = spent * 1024 / chunk;
+
+    lane->bytes += chunk;
+    lane->busy  += spent;
+
+    for (auto worst = lane->worst.load(); cost > worst;) {
+      if (lane->worst.compare_exchange_weak(worst, cost)) {
+        break;
+      }
+    }
+  }
+
+  entry->lastYield = now;
+  entry->remaining = remaining;
+
+  // close the window, only one thread wins it
+  auto window = lane->window.load();
+  auto millis = now / 1000000;
+
+  if (millis - window < sampleInterval || !lane->window.compare_exchange_strong(window, millis)) {
+    return;
+  }
+
+  QMutexLocker locker(&mutex);
+  this->adapt(lane, millis - window);
+}
+
+/**
+ * @brief Adapt the limit of the lane to the last window, one more copy
+ * while the throughput of a full lane beats the one of the last raise
+ * and a multiplicative cut on a fall, on a failed copy or on a chunk
+ * that stalled far beyond the usual, the limit holds in between, a
+ * lane that never filled up keeps its limit since its throughput says
+ * nothing about the devices, needs the lock
+ */
+void Scheduler::adapt(Lane *lane, qint64 elapsed) {
+  auto bytes  = lane->bytes.exchange(0);
+  auto busy   = lane->busy.exchange(0);
+  auto worst  = lane->worst.exchange(0);
+  auto errors = std::exchange(lane->errors, 0);
+  auto full   = std::exchange(lane->full, lane->running >= lane->limit);
+  auto limit  = lane->limit;
+
+  auto throughput = bytes * 1000 / std::max<qint64>(elapsed, 1);
+  auto stall      = lane->baseline > 0 && worst > stallFactor * lane->baseline;
+
+  // usual cost of a chunk
+  if (bytes > 0) {
+    auto cost = static_cast<double>(busy) * 1024 / bytes;
+    lane->baseline = lane->baseline > 0 ? lane->baseline * 0.8 + cost * 0.2 : cost;
+  }
+
+  // the falling throughput of the cut lane is no news, the one
+  // before the cut has to be beaten to raise the limit again
+  const auto cut = [&] {
+    lane->limit = std::max(1, static_cast<int>(lane->limit * decrease));
+    lane->last  = 0;
+  };
+
+  if (errors > 0 || stall) {
+    cut();
+  } else if (full && bytes > 0 && throughput < lane->last * (1 - tolerance)) {
+    cut();
+  } else if (full && bytes > 0 && throughput > lane->throughput * (1 + tolerance)) {
+    lane->limit      = std::min(lane->limit + 1, lane->ceiling);
+    lane->throughput = throughput;
+    lane->last       = throughput;
+  } else if (full && bytes > 0) {
+    lane->last = throughput;
+  }
+
+  if (bytes > 0 || lane->limit != limit) {
+    lane->history.append(Sample{clock.elapsed(), throughput, lane->limit});
+  }
+
+  if (lane->history.size() > historySize) {
+    lane->history.removeFirst();
+  }
+
+  // a raised limit may start a waiting copy
+  if (lane->limit > limit) {
+    this->dispatch();
+  }
+}
+
+/**
+ * @brief Destroy the Scheduler object, the pool is drained by shutdown
+ * while the singletons the copies use are still alive
+ */
+Scheduler::~Scheduler() {
+  qDeleteAll(lanes);
+}
+
+/**
+ * @brief Stop taking copies and wait for the running ones, the waiting
+ * copies are dropped since the journal queues them again on the next
+ * start and a paused copy is resumed so it can see its cancel, the copies
+ * in flight should be canceled before or they run to their end
+ */
+void Scheduler::shutdown() {
+  QMutexLocker locker(&mutex);
+  stopping = true;
+
+  for (auto it = entries.begin(); it != entries.end();) {
+    auto entry = *it;
+
+    if (entry->running) {
+      ++it;
+      continue;
+    }
+
+    if (entry->paused) {
+      entry->paused = false;
+      this->occupy(entry);
+      ++it;
+      continue;
+    }
+
+    if (entry->runnable->autoDelete()) {
+      delete entry->runnable;
+    }
+
+    Budget::instance().release(Budget::Queue::COPY, entry->cost);
+    it = entries.erase(it);
+    delete entry;
+  }
+
+  condition.wakeAll();
+  locker.unlock();
+
+  pool.waitForDone();
+}
+
+/**
+ * @brief Set the rules, the first matching rule wins
+ */
+void Scheduler::setRules(const QList<Rule> &rules) {
+  QMutexLocker locker(&mutex);
+  this->rules = rules;
+}
+
+/**
+ * @brief Get the rules
+ */
+QList<Scheduler::Rule> Scheduler::getRules() const {
+  QMutexLocker locker(&mutex);
+  return rules;
+}
+
+/**
+ * @brief Queue the runnable of the copier from the file to the
+ * destination, the scheduler takes over the ownership of the runnable,
+ * a new lane starts from the limit of its devices
+ */
+void Scheduler::submit(const void *key, QRunnable *runnable, const QString &from, const QString &to, qint64 size) {
+  // devices are looked up without the lock
+  auto devices = qMakePair(deviceOf(from), deviceOf(to));
+
+  QMutexLocker locker(&mutex);
+
+  // nothing starts once shut down
+  if (stopping) {
+    if (runnable->autoDelete()) {
+      delete runnable;
+    }
+
+    return;
+  }
+
+  auto lane = lanes.value(devices);
+
+  if (!lane) {
+    lane = lanes[devices] = new Lane;
+    lane->limit   = std::min(limitOf(devices.first), limitOf(devices.second));
+    lane->ceiling = std::min(lane->limit * growth, threads);
+  }
+
+  // held in the copy queue until it is done
+  auto cost = entryCost + (from.size() + to.size()) * static_cast<qint64>(sizeof(QChar));
+  Budget::instance().acquire(Budget::Queue::COPY, cost);
+
+  entries.append(new Entry{
+    key, runnable, this->classOf(from, size), std::max<qint64>(size, 0), clock.elapsed(), lane, cost
+  });
+
+  this->dispatch();
+}
+
+/**
+ * @brief Called by a running copy at a chunk boundary, the pool thread
+ * is released while paused so the urgent copy gets a thread of its own,
+ * the aging of the paused copy starts over so it isn't resumed at once
+ */
+void Scheduler::yield(const void *key, qint64 remaining) {
+  // the entry of the copy on this thread
+  if (current && current->key == key) {
+    this->account(current, remaining);
+  }
+
+  // nothing to pause, the common case costs one atomic load
+  if (preempting.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+
+  QMutexLocker locker(&mutex);
+  auto entry = this->find(key);
+
+  if (!entry) {
+    return;
+  }
+
+  entry->remaining = remaining;
+
+  if (!entry->preempt) {
+    return;
+  }
+
+  entry->preempt  = false;
+  entry->running  = false;
+  entry->paused   = true;
+  entry->enqueued = clock.elapsed();
+  entry->lane->running--;
+  preempting--;
+  running--;
+
+  pool.releaseThread();
+  this->dispatch();
+
+  while (entry->paused) {
+    condition.wait(&mutex);
+  }
+
+  // the pause is no latency of the lane
+  entry->lastYield = clock.nsecsElapsed();
+
+  locker.unlock();
+  pool.reserveThread();
+}
+
+/**
+ * @brief Called when a copy failed, the lane backs off at the end of
+ * the window so a burst of failures cuts the limit once, a failure
+ * that says nothing about the devices doesn't count
+ */
+void Scheduler::fault(const void *key, int error) {
+  if (!isFault(error)) {
+    return;
+  }
+
+  QMutexLocker locker(&mutex);
+
+  if (auto entry = this->find(key)) {
+    entry->lane->errors++;
+    entry->failed = true;
+  }
+}
+
+/**
+ * @brief Limit and throughput history of the lanes
+ */
+QList<Scheduler::LaneStatus> Scheduler::getLanes() const {
+  QMutexLocker locker(&mutex);
+  QList<LaneStatus> status;
+
+  for (auto it = lanes.cbegin(); it != lanes.cend(); ++it) {
+    status.append(LaneStatus{it.key(), it.value()->limit, it.value()->running, it.value()->history});
+  }
+
+  return status;
+}
+
+/**
+ * @brief Instance of the scheduler
+ */
+Scheduler &Scheduler::instance() {
+  static Scheduler instance;
+  return instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,296 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QRunnable>
+#include <QStorageInfo>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include "common/budget/budget.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Size aware scheduler of the copy tasks on a pool of its own, the
+ * task with the most urgent class runs first and shortest remaining first
+ * within a class, waiting tasks age into better classes and a running
+ * bulk copy can be paused at a chunk boundary for an urgent one, copies
+ * run in lanes keyed by the source and destination device and a lane
+ * never runs more copies than its devices take
+ */
+class Scheduler {
+ private:
+  Q_DISABLE_COPY_MOVE(Scheduler)
+
+ public:
+
+  /**
+   * @brief Rule that puts matching files into a class, lower is
+   * more urgent, a negative bound of the size is open
+   */
+  struct Rule {
+    int priority = 0;
+    QString path;          // prefix of the path, empty matches all
+    QStringList suffixes;  // file suffixes, empty matches all
+    qint64 minSize = -1;
+    qint64 maxSize = -1;
+
+    /**
+     * @brief does the file match the rule
+     */
+    bool matches(const QString &file, qint64 size) const;
+
+    /**
+     * @brief Serialize as class=N;path=P;ext=a,b;size=min-max
+     */
+    QString toString() const;
+
+    /**
+     * @brief Parse from class=N;path=P;ext=a,b;size=min-max
+     */
+    static Rule fromString(const QString &rule);
+  };
+
+ public:
+  // source and destination device
+  using LaneKey = QPair<quint64, quint64>;
+
+  /**
+   * @brief Throughput of a lane over a sampling window
+   */
+  struct Sample {
+    qint64 time;        // milliseconds on the clock
+    qint64 throughput;  // bytes per second
+    int limit;          // limit after the window
+  };
+
+  /**
+   * @brief State of a lane for the ones watching it converge
+   */
+  struct LaneStatus {
+    LaneKey key;
+    int limit;
+    int running;
+    QList<Sample> history;
+  };
+
+ private:
+  // copies between a pair of devices, the limit follows the
+  // throughput like the congestion window of TCP
+  struct Lane {
+    int limit   = 0;
+    int ceiling = 0;            // most the limit grows to
+    int running = 0;
+    int errors  = 0;
+    bool full   = false;        // reached the limit in the window
+    qint64 throughput = 0;      // of the last raise, kept across cuts
+    qint64 last       = 0;      // of the last full window, 0 after a cut
+    double baseline   = 0;      // usual ns per KiB of a chunk
+    QList<Sample> history;
+    std::atomic<qint64> window = 0;  // start in ms
+    std::atomic<qint64> bytes  = 0;
+    std::atomic<qint64> busy   = 0;  // ns spent on the bytes
+    std::atomic<qint64> worst  = 0;  // slowest chunk in ns per KiB
+  };
+
+  // a submitted task
+  struct Entry {
+    const void *key;
+    QRunnable *runnable;
+    int priority;
+    qint64 remaining;
+    qint64 enqueued;  // milliseconds on the clock
+    Lane *lane;
+    qint64 cost;           // bytes in the copy queue
+    qint64 lastYield = 0;  // ns on the clock
+    bool running = false;
+    bool paused  = false;
+    bool preempt = false;
+    bool failed  = false;
+  };
+
+ private:
+  static inline const qint64 agingInterval = 10000;  // ms per class
+  static inline const qint64 smallSize     = 1 << 20;
+  static inline const qint64 bulkSize      = 64 << 20;
+  static inline const qint64 entryCost     = 1024;  // entry and copier
+
+ private:  // copies a device takes at once
+  static inline const int threads         = 64;
+  static inline const int rotationalLimit = 2;
+  static inline const int solidLimit      = 8;
+  static inline const int remoteLimit     = 16;
+
+ private:  // adapting the limit of a lane
+  static inline const qint64 sampleInterval = 1000;  // ms per window
+  static inline const qsizetype historySize = 120;
+  static inline const double decrease       = 0.7;
+  static inline const double tolerance      = 0.1;   // noise of the throughput
+  static inline const int growth            = 4;     // ceiling over the limit of the devices
+  static inline const double stallFactor    = 4.0;
+
+ private:
+  QList<Entry *> entries;
+  QHash<LaneKey, Lane *> lanes;
+  QList<Rule> rules;
+  QElapsedTimer clock;
+  QThreadPool pool;
+  QWaitCondition condition;
+  std::atomic<int> preempting = 0;
+  int running = 0;
+  bool stopping = false;
+  mutable QMutex mutex;
+
+ private:
+  // entry run by the pool thread, lets a chunk be
+  // accounted without looking the entry up
+  static inline thread_local Entry *current = nullptr;
+
+ private:
+
+  /**
+   * @brief Construct a new Scheduler object
+   */
+  Scheduler();
+
+  /**
+   * @brief Device of the path or of its closest existing parent
+   */
+  static quint64 deviceOf(const QString &path);
+
+  /**
+   * @brief Copies the device takes at once
+   */
+  static int limitOf(quint64 device);
+
+  /**
+   * @brief Is the error a sign of a struggling device
+   */
+  static bool isFault(int error);
+
+  /**
+   * @brief Class of the file by the rules, falls back to the size
+   */
+  int classOf(const QString &file, qint64 size) const;
+
+  /**
+   * @brief Class of the entry improved by the time it waited
+   */
+  int effective(const Entry *entry, qint64 now) const;
+
+  /**
+   * @brief Entry of the key, needs the lock
+   */
+  Entry *find(const void *key) const;
+
+  /**
+   * @brief Best waiting entry of a lane with a free slot, the
+   * lane of the thread wins a tie, needs the lock
+   */
+  Entry *best(const Lane *preferred = nullptr) const;
+
+  /**
+   * @brief Mark the entry running, needs the lock
+   */
+  void occupy(Entry *entry);
+
+  /**
+   * @brief Run the entry and then whatever the thread can take
+   */
+  void drain(Entry *entry);
+
+  /**
+   * @brief Start or resume the best waiting entries, needs the lock
+   */
+  void dispatch();
+
+  /**
+   * @brief Ask the least urgent copy of a full lane to pause, needs the lock
+   */
+  void preempt();
+
+  /**
+   * @brief Account the chunk of the running entry without the lock
+   */
+  void account(Entry *entry, qint64 remaining);
+
+  /**
+   * @brief Adapt the limit of the lane to the last window, needs the lock
+   */
+  void adapt(Lane *lane, qint64 elapsed);
+
+ public:
+
+  /**
+   * @brief Destroy the Scheduler object
+   */
+  ~Scheduler();
+
+  /**
+   * @brief Stop taking copies and wait for the running ones
+   */
+  void shutdown();
+
+  /**
+   * @brief Set the rules, the first matching rule wins
+   */
+  void setRules(const QList<Rule> &rules);
+
+  /**
+   * @brief Get the rules
+   */
+  QList<Rule> getRules() const;
+
+  /**
+   * @brief Queue the runnable of the copier from the file to the destination
+   */
+  void submit(const void *key, QRunnable *runnable, const QString &from, const QString &to, qint64 size);
+
+  /**
+   * @brief Called by a running copy at a chunk boundary, blocks while
+   * the copy is paused for a more urgent one
+   */
+  void yield(const void *key, qint64 remaining);
+
+  /**
+   * @brief Called when a copy failed, the lane backs off
+   */
+  void fault(const void *key, int error);
+
+  /**
+   * @brief Limit and throughput history of the lanes
+   */
+  QList<LaneStatus> getLanes() const;
+
+  /**
+   * @brief Instance of the scheduler
+   */
+  static Scheduler &instance();
+};
+}  // namespace srilakshmikanthanp::pulldog::common
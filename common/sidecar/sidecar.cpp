@@ -0,0 +1,191 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "sidecar.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Path of the sidecar of the destination
+ */
+QString Sidecar::pathOf(const QString &dest) {
+  auto info = QFileInfo(dest);
+  return info.dir().filePath("." + info.fileName() + suffix);
+}
+
+/**
+ * @brief File id of the file, 0 if it can't be had
+ */
+QPair<quint64, quint64> Sidecar::idOf(const QString &file) {
+  try {
+    return utility::getFileId(file);
+  } catch (const std::exception &) {
+    return {0, 0};
+  }
+}
+
+/**
+ * @brief Load the sidecar of the destination, the format is
+ * xxh3:<hash> <src size> <src mtime> <dest size> <dest mtime>
+ * followed by <src device> <src inode>, a record written before
+ * the file id was recorded ends after the times
+ */
+std::optional<Sidecar::Record> Sidecar::load(const QString &dest) {
+  QFile file(pathOf(dest));
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    return std::nullopt;
+  }
+
+  auto fields = QString::fromLatin1(file.readLine()).trimmed().split(' ');
+
+  if ((fields.size() != 5 && fields.size() != 7) || !fields[0].startsWith("xxh3:")) {
+    return std::nullopt;
+  }
+
+  Record record;
+  bool ok[7] = {true, true, true, true, true, true, true};
+
+  record.hash      = fields[0].mid(5).toULongLong(&ok[0], 16);
+  record.srcSize   = fields[1].toLongLong(&ok[1]);
+  record.srcMtime  = fields[2].toLongLong(&ok[2]);
+  record.destSize  = fields[3].toLongLong(&ok[3]);
+  record.destMtime = fields[4].toLongLong(&ok[4]);
+
+  if (fields.size() == 7) {
+    record.srcId.first  = fields[5].toULongLong(&ok[5]);
+    record.srcId.second = fields[6].toULongLong(&ok[6]);
+  }
+
+  for (auto valid : ok) {
+    if (!valid) return std::nullopt;
+  }
+
+  return record;
+}
+
+/**
+ * @brief Store the record for the destination, the record is written
+ * beside and renamed over the old one without a sync of its own, the
+ * next group commit into the directory syncs it along, a sidecar lost
+ * or torn by a crash doesn't parse and the destination is then compared
+ * by its content
+ */
+bool Sidecar::save(const QString &dest, const Record &record) {
+  auto path = pathOf(dest);
+  QFile file(path + staging);
+
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    return false;
+  }
+
+  auto line = QString("xxh3:%1 %2 %3 %4 %5 %6 %7\n")
+                  .arg(record.hash, 16, 16, QChar('0'))
+                  .arg(record.srcSize)
+                  .arg(record.srcMtime)
+                  .arg(record.destSize)
+                  .arg(record.destMtime)
+                  .arg(record.srcId.first)
+                  .arg(record.srcId.second);
+
+  auto data = line.toLatin1();
+  auto done = file.write(data) == data.size();
+  file.close();
+
+  std::error_code error;
+
+  if (done) {
+    std::filesystem::rename(file.fileName().toStdWString(), path.toStdWString(), error);
+  }
+
+  if (!done || error) {
+    file.remove();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Remove the sidecar of the destination
+ */
+void Sidecar::remove(const QString &dest) {
+  QFile::remove(pathOf(dest));
+}
+
+/**
+ * @brief Move the sidecar along with the renamed destination, a
+ * sidecar left at the new name belongs to the replaced file
+ */
+bool Sidecar::move(const QString &from, const QString &to) {
+  QFile::remove(pathOf(to));
+  return QFile::rename(pathOf(from), pathOf(to));
+}
+
+/**
+ * @brief Re-hash the local destination and compare it with the sidecar
+ */
+bool Sidecar::verify(const QString &dest) {
+  auto record = load(dest);
+  auto hash   = Checksum::of(dest);
+  return record && hash && record->hash == *hash;
+}
+
+/**
+ * @brief is the destination up to date, compares metadata against the
+ * sidecar without reading the source and falls back to sampling the
+ * content when there is no sidecar
+ */
+bool Sidecar::isUptoDate(const QString &src, const QString &dest) {
+  auto record = load(dest);
+
+  if (!record) {
+    return utility::isUptoDate(src, dest);
+  }
+
+  QFileInfo srcInfo(src), destInfo(dest);
+
+  if (!srcInfo.exists() || !destInfo.exists()) {
+    return false;
+  }
+
+  // source changed since it was copied
+  if (
+    srcInfo.size() != record->srcSize ||
+    srcInfo.lastModified().toMSecsSinceEpoch() != record->srcMtime
+  ) {
+    return false;
+  }
+
+  // destination changed or was torn since it was copied
+  if (
+    destInfo.size() != record->destSize ||
+    destInfo.lastModified().toMSecsSinceEpoch() != record->destMtime
+  ) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief is the destination an up to date copy of that very source file,
+ * the file id is kept by a rename so a moved source still passes while
+ * an other file that happens to have the same size and time doesn't, a
+ * record that predates the file id is compared by the metadata alone
+ */
+bool Sidecar::isCopyOf(const QString &src, const QString &dest) {
+  auto record = load(dest);
+
+  if (!record) {
+    return false;
+  }
+
+  if (record->srcId != Record().srcId && record->srcId != idOf(src)) {
+    return false;
+  }
+
+  return isUptoDate(src, dest);
+}
+}  // namespace srilakshmikanthanp::pulldog::common
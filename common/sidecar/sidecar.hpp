@@ -0,0 +1,100 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include <QString>
+
+#include <filesystem>
+#include <optional>
+#include <system_error>
+
+#include "common/checksum/checksum.hpp"
+#include "utility/functions/functions.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Hidden file next to the destination that remembers the checksum
+ * of the copied content together with the size and modification time of
+ * the source and the destination at the time of the copy and the file id
+ * of the source
+ */
+class Sidecar {
+ public:
+
+  /**
+   * @brief Record stored in the sidecar
+   */
+  struct Record {
+    quint64 hash     = 0;
+    qint64 srcSize   = -1;
+    qint64 srcMtime  = 0;  // milliseconds since epoch
+    qint64 destSize  = -1;
+    qint64 destMtime = 0;  // milliseconds since epoch
+    QPair<quint64, quint64> srcId = {0, 0};  // unknown for older records
+  };
+
+ private:
+  static inline const char *suffix  = ".pulldog-sum";
+  static inline const char *staging = ".new";  // of a record being written
+
+ private:
+
+  /**
+   * @brief File id of the file, 0 if it can't be had
+   */
+  static QPair<quint64, quint64> idOf(const QString &file);
+
+ public:
+
+  /**
+   * @brief Path of the sidecar of the destination
+   */
+  static QString pathOf(const QString &dest);
+
+  /**
+   * @brief Load the sidecar of the destination
+   */
+  static std::optional<Record> load(const QString &dest);
+
+  /**
+   * @brief Store the record for the destination
+   */
+  static bool save(const QString &dest, const Record &record);
+
+  /**
+   * @brief Remove the sidecar of the destination
+   */
+  static void remove(const QString &dest);
+
+  /**
+   * @brief Move the sidecar along with the renamed destination
+   */
+  static bool move(const QString &from, const QString &to);
+
+  /**
+   * @brief Re-hash the local destination and compare it with the sidecar
+   */
+  static bool verify(const QString &dest);
+
+  /**
+   * @brief is the destination up to date, compares metadata against the
+   * sidecar without reading the source and falls back to sampling the
+   * content when there is no sidecar
+   */
+  static bool isUptoDate(const QString &src, const QString &dest);
+
+  /**
+   * @brief is the destination an up to date copy of that very source
+   * file, a source with the same size and time doesn't pass for it
+   */
+  static bool isCopyOf(const QString &src, const QString &dest);
+};
+}  // namespace srilakshmikanthanp::pulldog::common
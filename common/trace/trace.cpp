@@ -0,0 +1,146 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "trace.hpp"
+
+namespace srilakshmikanthanp::pulldog::common {
+// buffer of the calling thread
+thread_local Tracer::Handle Tracer::handle;
+
+/**
+ * @brief Give the buffer back when the thread ends, its spans stay
+ * for the dump until another thread writes over them
+ */
+Tracer::Handle::~Handle() {
+  if (buffer) {
+    Tracer::instance().release(buffer);
+  }
+}
+
+/**
+ * @brief Buffer for a thread, one of an ended thread if any so the
+ * threads that come and go don't pile buffers up
+ */
+Tracer::Buffer *Tracer::acquire() {
+  QMutexLocker locker(&mutex);
+
+  if (!spare.isEmpty()) {
+    return spare.takeLast();
+  }
+
+  buffers.append(new Buffer());
+  return buffers.last();
+}
+
+/**
+ * @brief Give the buffer of an ended thread back
+ */
+void Tracer::release(Buffer *buffer) {
+  QMutexLocker locker(&mutex);
+  spare.append(buffer);
+}
+
+/**
+ * @brief Record a finished span of the calling thread, the sequence
+ * number is odd while the span is written
+ */
+void Tracer::record(const char *name, qint64 begin, qint64 duration, quint64 id) {
+  if (!handle.buffer) {
+    handle.buffer = this->acquire();
+    handle.tid    = ++tids;
+  }
+
+  auto buffer = handle.buffer;
+  auto index  = buffer->head.load(std::memory_order_relaxed);
+  auto &entry = buffer->records[index % capacity];
+
+  entry.seq.store(index * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  entry.name.store(name, std::memory_order_relaxed);
+  entry.begin.store(begin, std::memory_order_relaxed);
+  entry.duration.store(duration, std::memory_order_relaxed);
+  entry.id.store(id, std::memory_order_relaxed);
+  entry.tid.store(handle.tid, std::memory_order_relaxed);
+
+  entry.seq.store(index * 2 + 2, std::memory_order_release);
+  buffer->head.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief The spans as Chrome trace event JSON, complete events in
+ * microseconds, a span written meanwhile is left out
+ */
+QByteArray Tracer::dump() {
+  QMutexLocker locker(&mutex);
+  auto all = buffers;
+  locker.unlock();
+
+  auto pid = QByteArray::number(QCoreApplication::applicationPid());
+  QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  auto first = true;
+
+  for (auto buffer : all) {
+    auto end   = buffer->head.load(std::memory_order_acquire);
+    auto start = end > capacity ? end - capacity : 0;
+
+    for (auto index = start; index < end; ++index) {
+      auto &entry = buffer->records[index % capacity];
+      auto seq    = entry.seq.load(std::memory_order_acquire);
+
+      auto name     = entry.name.load(std::memory_order_relaxed);
+      auto begin    = entry.begin.load(std::memory_order_relaxed);
+      auto duration = entry.duration.load(std::memory_order_relaxed);
+      auto id       = entry.id.load(std::memory_order_relaxed);
+      auto tid      = entry.tid.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (seq != index * 2 + 2 || entry.seq.load(std::memory_order_relaxed) != seq) {
+        continue;
+      }
+
+      json += first ? "" : ",";
+      json += "{\"name\":\"" + QByteArray(name) + "\",\"cat\":\"pulldog\",\"ph\":\"X\"";
+      json += ",\"ts\":" + QByteArray::number(static_cast<double>(begin) / 1e3, 'f', 3);
+      json += ",\"dur\":" + QByteArray::number(static_cast<double>(duration) / 1e3, 'f', 3);
+      json += ",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(tid);
+
+      if (id) {
+        json += ",\"args\":{\"id\":\"" + QByteArray::number(id, 16) + "\"}";
+      }
+
+      json += "}";
+      first = false;
+    }
+  }
+
+  json += "]}";
+  return json;
+}
+
+/**
+ * @brief Write the spans as Chrome trace event JSON to the file
+ */
+bool Tracer::dump(const QString &file) {
+  QSaveFile out(file);
+
+  if (!out.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  out.write(this->dump());
+  return out.commit();
+}
+
+/**
+ * @brief Instance of the tracer, it lives until the process ends
+ * since threads give their buffers back as late as their end
+ */
+Tracer &Tracer::instance() {
+  static Tracer *instance = new Tracer();
+  return *instance;
+}
+}  // namespace srilakshmikanthanp::pulldog::common
@@ -0,0 +1,155 @@
+#pragma once  // #include only once see https://en.wikipedia.org/wiki/Pragma_once
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace srilakshmikanthanp::pulldog::common {
+/**
+ * @brief Spans of the pipeline kept in a ring of every thread, a thread
+ * only ever writes its own ring so a span costs two reads of the clock
+ * and a few relaxed stores, the rings are read when they are dumped as
+ * Chrome trace events for chrome://tracing or Perfetto
+ */
+class Tracer {
+ private:
+  Q_DISABLE_COPY_MOVE(Tracer)
+
+ private:
+  static inline const size_t capacity = 4096;  // spans of a thread
+
+ private:
+  // a finished span, written under a sequence number so a dump that
+  // races the thread throws away the span it caught half written
+  struct Record {
+    std::atomic<quint64> seq       = 0;  // odd while written
+    std::atomic<const char *> name = nullptr;
+    std::atomic<qint64> begin      = 0;  // ns on the clock
+    std::atomic<qint64> duration   = 0;  // ns
+    std::atomic<quint64> id        = 0;  // of the transfer, 0 if none
+    std::atomic<quint32> tid       = 0;
+  };
+
+  // spans of a thread, written only by the thread that holds it
+  struct Buffer {
+    std::array<Record, capacity> records;
+    std::atomic<quint64> head = 0;  // spans written
+  };
+
+  // buffer of the thread, given back when the thread ends
+  struct Handle {
+    Buffer *buffer = nullptr;
+    quint32 tid    = 0;
+    ~Handle();
+  };
+
+ private:
+  QList<Buffer *> buffers;  // all of them, owned
+  QList<Buffer *> spare;    // of the threads that ended
+  std::atomic<quint32> tids = 0;
+  QMutex mutex;
+
+ private:
+  static thread_local Handle handle;  // of the calling thread
+
+ private:
+  /**
+   * @brief Construct a new Tracer object
+   */
+  Tracer() = default;
+
+  /**
+   * @brief Buffer for a thread, one of an ended thread if any
+   */
+  Buffer *acquire();
+
+  /**
+   * @brief Give the buffer of an ended thread back
+   */
+  void release(Buffer *buffer);
+
+ public:
+  /**
+   * @brief ns on the monotonic clock
+   */
+  static qint64 now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+
+  /**
+   * @brief Record a finished span of the calling thread
+   */
+  void record(const char *name, qint64 begin, qint64 duration, quint64 id);
+
+  /**
+   * @brief The spans as Chrome trace event JSON
+   */
+  QByteArray dump();
+
+  /**
+   * @brief Write the spans as Chrome trace event JSON to the file
+   */
+  bool dump(const QString &file);
+
+  /**
+   * @brief Instance of the tracer
+   */
+  static Tracer &instance();
+};
+
+/**
+ * @brief Span from its construction to the end of its scope, use it
+ * through PULLDOG_TRACE_SPAN so it is gone when tracing is compiled out
+ */
+class Span {
+ private:
+  Q_DISABLE_COPY_MOVE(Span)
+
+ private:
+  const char *name;
+  quint64 id;
+  qint64 begin;
+
+ public:
+  /**
+   * @brief Start the span
+   */
+  explicit Span(const char *name, quint64 id = 0) : name(name), id(id), begin(Tracer::now()) {}
+
+  /**
+   * @brief End the span
+   */
+  ~Span() {
+    Tracer::instance().record(name, begin, Tracer::now() - begin, id);
+  }
+};
+}  // namespace srilakshmikanthanp::pulldog::common
+
+// spans are compiled in with PULLDOG_TRACE only
+#ifdef PULLDOG_TRACE
+#define PULLDOG_TRACE_CONCAT_(a, b) a##b
+#define PULLDOG_TRACE_CONCAT(a, b) PULLDOG_TRACE_CONCAT_(a, b)
+#define PULLDOG_TRACE_SPAN(name) \
+  ::srilakshmikanthanp::pulldog::common::Span PULLDOG_TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define PULLDOG_TRACE_SPAN_ID(name, id) \
+  ::srilakshmikanthanp::pulldog::common::Span PULLDOG_TRACE_CONCAT(traceSpan, __LINE__)(name, id)
+#else
+#define PULLDOG_TRACE_SPAN(name) do {} while (0)
+#define PULLDOG_TRACE_SPAN_ID(name, id) do {} while (0)
+#endif
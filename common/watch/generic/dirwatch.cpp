@@ -24,9 +24,20 @@ QString DirWatcher::getPath() const {
 }
 
 /**
- * @brief Poll the directory
+ * @brief Entries seen by the last poll
  */
-bool DirWatcher::poll() {
+qint64 DirWatcher::getScanned() const {
+  return scanned;
+}
+
+/**
+ * @brief Poll the directory, the files beyond the quota are left out of
+ * the cache so the next poll reports them again, the subtree is deferred
+ * to the file system instead of being buffered in memory
+ */
+bool DirWatcher::poll(qint64 &quota) {
+  PULLDOG_TRACE_SPAN("DirWatcher::poll");
+
   QList<FileInfo> entryCreated, entryUpdated, entryRemoved;
   QList<QPair<FileInfo, FileInfo>> entryRenamed;
 
@@ -38,12 +49,22 @@ bool DirWatcher::poll() {
     return QDir::cleanPath(QString::fromStdWString(relPath.wstring()));
   };
 
+  // entries seen by this poll
+  scanned = 0;
+
   // for created and updated files
   for(const auto &file: fs::recursive_directory_iterator(path.toStdWString())) {
+    scanned++;
+
     auto fileInfo = QFileInfo(QString::fromStdWString(file.path().wstring()));
     auto fileId   = types::FileId(fileInfo.filePath());
     auto filePath = fileInfo.filePath();
 
+    // the rest waits for the next poll
+    if(entryCreated.size() + entryUpdated.size() >= quota) {
+      break;
+    }
+
     // if the file is not in the cache
     if(!files.contains(filePath)) {
       entryCreated.append({fileInfo, fileId});
@@ -74,12 +95,17 @@ bool DirWatcher::poll() {
     }
   }
 
-  // identify the renamed files from removed and created
+  // identify the renamed files from removed and created by the file
+  // id, a directory move of many files stays linear
+  QHash<types::FileId, FileInfo> removedById;
+
+  for(auto removed: entryRemoved) {
+    removedById.insert(std::get<1>(removed), removed);
+  }
+
   for(auto created: entryCreated) {
-    for(auto removed: entryRemoved) {
-      if(std::get<1>(created).isSameFile(std::get<1>(removed))) {
-        entryRenamed.append({removed, created});
-      }
+    if(auto removed = removedById.constFind(std::get<1>(created)); removed != removedById.cend()) {
+      entryRenamed.append({*removed, created});
     }
   }
 
@@ -89,6 +115,9 @@ bool DirWatcher::poll() {
     entryRemoved.removeOne(renamed.first);
   }
 
+  // the quota left for the other directories
+  quota -= entryCreated.size() + entryUpdated.size();
+
   // emit the signals for created
   for(auto info: entryCreated) {
     emit fileCreated(path, relativePath(std::get<0>(info).filePath()));
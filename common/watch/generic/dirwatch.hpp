@@ -7,6 +7,7 @@
 
 #include <QObject>
 #include <QDir>
+#include <QHash>
 #include <QMap>
 #include <QMutex>
 #include <QThread>
@@ -15,6 +16,7 @@
 
 #include <filesystem>
 
+#include "common/trace/trace.hpp"
 #include "common/watch/iwatch.hpp"
 #include "common/watch/win/watch.hpp"
 #include "types/fileid/fileid.hpp"
@@ -35,6 +37,7 @@ class DirWatcher : public QObject {
 
  private:
   QMap<QString, FileInfo> files;
+  qint64 scanned = 0;  // entries seen by the last poll
 
  signals:
   void fileCreated(const QString &dir, const QString &file);
@@ -58,15 +61,22 @@ class DirWatcher : public QObject {
   DirWatcher(const QString &path, QObject *parent = nullptr);
 
   /**
-   * @brief Poll the directory return true if any change
+   * @brief Poll the directory return true if any change, at most
+   * quota files are reported as created or updated and the quota
+   * is reduced by the reported ones
    */
-  bool poll();
+  bool poll(qint64 &quota);
 
   /**
    * @brief Get the Path object
    */
   QString getPath() const;
 
+  /**
+   * @brief Entries seen by the last poll
+   */
+  qint64 getScanned() const;
+
   /**
    * @brief Destroy the Directory Watcher object
    */
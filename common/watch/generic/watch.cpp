@@ -43,7 +43,7 @@ GenericWatch::~GenericWatch() {
 /**
  * @brief Poll the directory on its own thread
  */
-void GenericWatch::pollDirectory(DirWatcher *directory) {
+void GenericWatch::pollDirectory(DirWatcher *directory, qint64 &quota) {
   auto lastPoll = directory->property(lastPollKey).toDateTime();
   auto diff = lastPoll.msecsTo(QDateTime::currentDateTime());
   auto interval = directory->property(pollIntervalKey).toInt();
@@ -55,12 +55,22 @@ void GenericWatch::pollDirectory(DirWatcher *directory) {
 
   auto updated = false;
 
+  // the pipeline is full, the changes wait on the disk
+  if(quota <= 0) {
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
   try {
-    updated = directory->poll();
+    updated = directory->poll(quota);
   } catch (const std::filesystem::filesystem_error &e) {
     return emit onError(e.what());
   }
 
+  Metrics::instance().scanned(directory->getPath(), timer.elapsed(), directory->getScanned());
+
   auto time = QDateTime::currentDateTime();
   auto nInt = pollInterval;
 
@@ -77,8 +87,12 @@ void GenericWatch::pollDirectory(DirWatcher *directory) {
  */
 void GenericWatch::poll() {
   QMutexLocker locker(&mutex);
+
+  // room of the pipeline shared by the directories
+  auto quota = Budget::instance().room(Budget::Queue::WATCH);
+
   for(auto directory: directories) {
-    this->pollDirectory(directory);
+    this->pollDirectory(directory, quota);
   }
 }
 
@@ -147,6 +161,7 @@ void GenericWatch::removePath(const QString &dir) {
   directories.removeIf([path](auto dir) {
     return dir->getPath() == path;
   });
+  Metrics::instance().removeRoot(path);
   emit pathRemoved(path);
 }
 
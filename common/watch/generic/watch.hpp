@@ -7,6 +7,7 @@
 
 #include <QObject>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMap>
 #include <QMutex>
 #include <QThread>
@@ -15,6 +16,8 @@
 
 #include <filesystem>
 
+#include "common/budget/budget.hpp"
+#include "common/metrics/metrics.hpp"
 #include "common/watch/generic/dirwatch.hpp"
 #include "common/watch/iwatch.hpp"
 #include "common/watch/win/watch.hpp"
@@ -44,7 +47,7 @@ class GenericWatch : public IWatch {
   /**
    * @brief Poll the directory on its own thread
    */
-  void pollDirectory(DirWatcher *dir);
+  void pollDirectory(DirWatcher *dir, qint64 &quota);
 
   /**
    * @brief delegates the poll to the directories
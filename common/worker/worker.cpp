@@ -7,91 +7,188 @@
 
 namespace srilakshmikanthanp::pulldog::common {
 /**
- * @brief start to Copy the file with copier object
+ * @brief Forward the signals of the copier, the copier is removed
+ * from the table on any outcome of the transfer it reports, from its
+ * own thread so it is gone from the table before it is deleted
  */
-Worker::CopyStatus Worker::copy(const models::Transfer &transfer) {
-  // create all parent directories
-  if(!QDir().mkpath(QFileInfo(transfer.getTo()).dir().path())) {
-    return CopyStatus::Error;
-  }
-
-  // class of copier that inherits QRunnable
-  struct CopierRunnable : common::Copier, QRunnable {
-    void run() override { start(); }
-    using Copier::Copier;
-  };
-
+void Worker::connectCopier(common::ICopier *copier) {
   // cleaner for the copier
-  const auto remover = [this, transfer]() {
-    QMutexLocker locker(&copingMutex);
-    copingFiles.remove(transfer);
+  const auto remover = [this, copier](const models::Transfer &transfer) {
+    copingFiles.release(transfer, copier);
   };
 
-  // lock the mutex
-  QMutexLocker locker(&copingMutex);
-
-  // if already coping
-  if(copingFiles.contains(transfer)) {
-    return CopyStatus::Retry;
-  }
-
-  // create a copier object
-  auto copier = new CopierRunnable(transfer);
-
   // connect the signals
   connect(
-    copier, &common::Copier::onCopyCanceled,
+    copier, &common::ICopier::onCopyCanceled,
     this, &Worker::onCopyCanceled
   );
 
   connect(
-    copier, &common::Copier::onCopyStart,
+    copier, &common::ICopier::onCopyStart,
     this, &Worker::onCopyStart
   );
 
   connect(
-    copier, &common::Copier::onCopy,
+    copier, &common::ICopier::onCopy,
     this, &Worker::onCopy
   );
 
   connect(
-    copier, &common::Copier::onCopyEnd,
+    copier, &common::ICopier::onCopyEnd,
     this, &Worker::onCopyEnd
   );
 
   connect(
-    copier, &common::Copier::onCopyFailed,
+    copier, &common::ICopier::onCopyFailed,
     this, &Worker::onCopyFailed
   );
 
   connect(
-    copier, &common::Copier::onError,
+    copier, &common::ICopier::onCopyStats,
+    this, &Worker::onCopyStats
+  );
+
+  connect(
+    copier, &common::ICopier::onError,
     this, &Worker::onError
   );
 
-  // to remove the copier from the map
-  connect(copier, &common::Copier::onCopyCanceled, remover);
-  connect(copier, &common::Copier::onCopyEnd, remover);
-  connect(copier, &common::Copier::onCopyFailed, remover);
+  // a failed copy makes its lane back off, direct since
+  // the scheduler forgets the copy once it returns
+  connect(
+    copier, &common::ICopier::onCopyFailed,
+    copier, [copier](const models::Transfer &, int error) { Scheduler::instance().fault(copier, error); },
+    Qt::DirectConnection
+  );
+
+  // to remove the copier from the table
+  connect(copier, &common::ICopier::onCopyCanceled, copier, remover, Qt::DirectConnection);
+  connect(copier, &common::ICopier::onCopyEnd, copier, remover, Qt::DirectConnection);
+  connect(copier, &common::ICopier::onCopyFailed, copier, remover, Qt::DirectConnection);
+}
+
+/**
+ * @brief start to Copy the file with copier object
+ */
+Worker::CopyStatus Worker::copy(const models::Transfer &transfer, qint64 size) {
+  // create all parent directories
+  if(!QDir().mkpath(QFileInfo(transfer.getTo()).dir().path())) {
+    return CopyStatus::Error;
+  }
+
+  // class of copier that inherits QRunnable
+  struct CopierRunnable : common::Copier, QRunnable {
+    void run() override { start(); }
+    using Copier::Copier;
+  };
+
+  // if already coping the copy in flight is superseded
+  if(!copingFiles.claim(transfer)) {
+    return CopyStatus::Busy;
+  }
+
+  // create a copier object
+  auto copier = new CopierRunnable(transfer);
+
+  // connect the signals
+  this->connectCopier(copier);
 
   // add the copier to the coping files
-  copingFiles[transfer] = copier;
+  copingFiles.assign(transfer, copier);
+
+  // the size decides the class of the copy
+  if(size < 0) {
+    size = QFileInfo(transfer.getFrom()).size();
+  }
 
   // start the copy
-  QThreadPool::globalInstance()->start(copier);
+  Scheduler::instance().submit(
+    static_cast<common::ICopier *>(copier), copier, transfer.getFrom(), transfer.getTo(), size
+  );
 
   // return success
   return CopyStatus::Success;
 }
 
 /**
- * @brief Process the pending file update and return the status
+ * @brief Add the small file to the batch of its directory, the
+ * batches are started once the pending files are processed
  */
-Worker::CopyStatus Worker::process(const models::Transfer &pending) {
-  // extract the source and destination file
-  auto srcFile = pending.getFrom();
-  auto srcInfo = QFileInfo(srcFile);
+Worker::CopyStatus Worker::enqueue(const models::Transfer &transfer) {
+  // if already coping the copy in flight is superseded,
+  // the copier is set once the batch starts
+  if(!copingFiles.claim(transfer)) {
+    return CopyStatus::Busy;
+  }
+
+  // key of the batch
+  auto key = qMakePair(
+    QFileInfo(transfer.getFrom()).dir().path(),
+    QFileInfo(transfer.getTo()).dir().path()
+  );
 
+  // add to the batch
+  batches[key].append(transfer);
+
+  // return success
+  return CopyStatus::Success;
+}
+
+/**
+ * @brief Start a batch copier for every collected batch, a task
+ * carries at most batchLimit files so batches still run in parallel
+ */
+void Worker::copyBatches() {
+#ifdef __linux__
+  // class of batch copier that inherits QRunnable
+  struct BatchRunnable : common::BatchCopier, QRunnable {
+    void run() override { start(); }
+    using BatchCopier::BatchCopier;
+  };
+
+  for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+    // create all parent directories
+    if(!QDir().mkpath(it.key().second)) {
+      for (const auto &transfer : it.value()) {
+        copingFiles.release(transfer);
+        emit onCopyFailed(transfer, CopyStatus::Error);
+      }
+
+      continue;
+    }
+
+    for (qsizetype i = 0; i < it.value().size(); i += batchLimit) {
+      auto transfers = it.value().mid(i, batchLimit);
+      auto copier    = new BatchRunnable(transfers);
+
+      // connect the signals
+      this->connectCopier(copier);
+
+      connect(
+        copier, &common::BatchCopier::onBatchProgress,
+        this, &Worker::onBatchProgress
+      );
+
+      // add the copier to the coping files
+      for (const auto &transfer : transfers) {
+        copingFiles.assign(transfer, copier);
+      }
+
+      // start the copy, a batch is always small
+      Scheduler::instance().submit(
+        static_cast<common::ICopier *>(copier), copier, it.key().first, it.key().second, 0
+      );
+    }
+  }
+#endif
+
+  batches.clear();
+}
+
+/**
+ * @brief Probe whether the source can be copied now
+ */
+Worker::CopyStatus Worker::probe(const QFileInfo &srcInfo) {
   // ignore if it is not exists or it is a directory
   if(srcInfo.isDir()) {
     return CopyStatus::Directory;
@@ -104,11 +201,12 @@ Worker::CopyStatus Worker::process(const models::Transfer &pending) {
 
   // create an locker object
   common::Locker locker(
-    srcFile, Mode::EXCLUSIVE, Type::READ
+    srcInfo.filePath(), Mode::EXCLUSIVE, Type::READ
   );
 
   // lock
   auto status = locker.tryLock();
+  Metrics::instance().count(Metrics::Counter::LOCK_PROBES);
 
   // if it is non recoverable
   if(status == Error::UNRECOVERABLE) {
@@ -117,47 +215,271 @@ Worker::CopyStatus Worker::process(const models::Transfer &pending) {
 
   // if it is recoverable
   if(status == Error::RECOVERABLE) {
+    Metrics::instance().count(Metrics::Counter::LOCK_BUSY);
     return CopyStatus::Retry;
   }
 
   // unlock the file
   locker.unlock();
 
+  // return success
+  return CopyStatus::Success;
+}
+
+/**
+ * @brief Process the pending file update and return the status
+ */
+Worker::CopyStatus Worker::process(const models::Transfer &pending) {
+  PULLDOG_TRACE_SPAN_ID("Worker::process", qHash(pending.getTo()));
+
+  // extract the source file
+  auto srcInfo = QFileInfo(pending.getFrom());
+
+  // the writer must be done with it
+  if(auto status = this->probe(srcInfo); status != CopyStatus::Success) {
+    return status;
+  }
+
+#ifdef __linux__
+  // small files are copied together
+  if(srcInfo.size() < batchThreshold) {
+    return this->enqueue(pending);
+  }
+#endif
+
   // do copy
-  return this->copy(pending);
+  return this->copy(pending, srcInfo.size());
+}
+
+/**
+ * @brief Copy the source to all of its destinations reading it once,
+ * small files go to their batches since reading them again is cheap,
+ * returns the status of every transfer in order
+ */
+QList<Worker::CopyStatus> Worker::fanout(const QList<models::Transfer> &transfers) {
+  QList<CopyStatus> statuses;
+
+#ifdef __linux__
+  // extract the source file
+  auto srcInfo = QFileInfo(transfers.first().getFrom());
+
+  // class of fan out copier that inherits QRunnable
+  struct FanoutRunnable : common::FanoutCopier, QRunnable {
+    void run() override { start(); }
+    using FanoutCopier::FanoutCopier;
+  };
+
+  if(!srcInfo.isDir() && srcInfo.size() >= batchThreshold) {
+    // the writer must be done with it
+    if(auto status = this->probe(srcInfo); status != CopyStatus::Success) {
+      return QList<CopyStatus>(transfers.size(), status);
+    }
+
+    // every destination is claimed on its own
+    QList<models::Transfer> claimed;
+
+    for (const auto &transfer : transfers) {
+      if(!QDir().mkpath(QFileInfo(transfer.getTo()).dir().path())) {
+        statuses.append(CopyStatus::Error);
+      } else if(!copingFiles.claim(transfer)) {
+        statuses.append(CopyStatus::Busy);
+      } else {
+        statuses.append(CopyStatus::Success);
+        claimed.append(transfer);
+      }
+    }
+
+    if(claimed.isEmpty()) {
+      return statuses;
+    }
+
+    // create a copier object
+    auto copier = new FanoutRunnable(claimed);
+
+    // connect the signals
+    this->connectCopier(copier);
+
+    // add the copier to the coping files
+    for (const auto &transfer : claimed) {
+      copingFiles.assign(transfer, copier);
+    }
+
+    // the lane is the one of the first destination
+    Scheduler::instance().submit(
+      static_cast<common::ICopier *>(copier), copier, srcInfo.filePath(), claimed.first().getTo(), srcInfo.size()
+    );
+
+    return statuses;
+  }
+#endif
+
+  for (const auto &transfer : transfers) {
+    statuses.append(this->process(transfer));
+  }
+
+  return statuses;
+}
+
+/**
+ * @brief Schedule the next attempt of the file, the old node of the
+ * file stays in the heap and is skipped once it is popped, needs the lock
+ */
+void Worker::schedule(const models::Transfer &transfer, qint64 due) {
+  pendingFiles[transfer].due = due;
+  dueFiles.push(Due{due, transfer});
+}
+
+/**
+ * @brief Delay of the next attempt by the reason of the failure, a file
+ * that is still written backs off exponentially while a file that is
+ * being copied is tried again shortly to pick up the new content
+ */
+qint64 Worker::backoff(CopyStatus status, int failures) const {
+  if (status == CopyStatus::Busy) {
+    return busyDelay;
+  }
+
+  return std::min<qint64>(threshold << std::min(failures - 1, maxDoublings), maxBackoff);
 }
 
 /**
- * @brief Process the pending file update
+ * @brief Wake up when the earliest file is due, the stale nodes on the
+ * top are dropped first so they never wake the worker, needs the lock
+ */
+void Worker::arm() {
+  while (!dueFiles.empty()) {
+    auto &top = dueFiles.top();
+    auto pending = pendingFiles.constFind(top.transfer);
+
+    if (pending != pendingFiles.cend() && pending->due == top.due) {
+      break;
+    }
+
+    dueFiles.pop();
+  }
+
+  if (dueFiles.empty()) {
+    timer.stop();
+    return;
+  }
+
+  timer.start(std::max<qint64>(dueFiles.top().due - clock.elapsed(), 0));
+}
+
+/**
+ * @brief Process the pending files that are due, the files are taken
+ * out under the lock and probed without it so updates are never blocked,
+ * no more are taken than the copy queue has room for
  */
 void Worker::processPendingFileUpdate() {
-  // lock the mutex for pending files
+  QList<QPair<models::Transfer, int>> due;
+  auto now  = clock.elapsed();
+  auto room = Budget::instance().room(Budget::Queue::COPY);
+
+  // take the due files
   QMutexLocker locker(&pendingMutex);
-  QQueue<models::Transfer> failed;
 
-  for (auto pending: pendingFiles) {
-    switch (this->process(pending)) {
+  while (!dueFiles.empty() && dueFiles.top().due <= now && due.size() < room) {
+    auto node = dueFiles.top();
+    dueFiles.pop();
+
+    auto pending = pendingFiles.find(node.transfer);
+
+    if (pending == pendingFiles.end() || pending->due != node.due) {
+      continue;
+    }
+
+    due.append(qMakePair(node.transfer, pending->failures));
+    pendingFiles.erase(pending);
+    Budget::instance().release(Budget::Queue::WORK, Budget::costOf(node.transfer));
+  }
+
+  locker.unlock();
+
+  // a file that can't be copied yet
+  struct Failed {
+    models::Transfer transfer;
+    CopyStatus status;
+    int failures;
+  };
+
+  // the destinations of a source are copied together
+  QMap<QString, QList<models::Transfer>> sources;
+  QMap<models::Transfer, CopyStatus> statuses;
+
+  for (const auto &[pending, failures] : due) {
+    sources[pending.getFrom()].append(pending);
+  }
+
+  // probe and copy without the lock
+  for (const auto &transfers : std::as_const(sources)) {
+    auto results = transfers.size() > 1 ? this->fanout(transfers) : QList<CopyStatus>{this->process(transfers.first())};
+
+    for (qsizetype i = 0; i < transfers.size(); ++i) {
+      statuses.insert(transfers[i], results[i]);
+    }
+  }
+
+  QList<Failed> failed;
+
+  for (const auto &[pending, failures] : due) {
+    switch (auto status = statuses.value(pending)) {
     case CopyStatus::Error:
       emit onCopyFailed(pending, CopyStatus::Error);
       break;
     case CopyStatus::Retry:
-      failed.enqueue(pending);
+      failed.append(Failed{pending, status, failures + 1});
+      break;
+    case CopyStatus::Busy:
+      failed.append(Failed{pending, status, failures});
+      break;
+    case CopyStatus::Directory:
+      Journal::instance().skipped(pending);
+      Metrics::instance().skipped(pending);
+      break;
+    default:
       break;
     }
   }
 
-  // swap the failed files
-  pendingFiles.swap(failed);
+  // start the collected batches
+  this->copyBatches();
+
+  // put back the failed files unless they were updated meanwhile
+  locker.relock();
+  now = clock.elapsed();
+
+  for (const auto &[pending, status, failures] : failed) {
+    if (pendingFiles.contains(pending)) {
+      continue;
+    }
+
+    Budget::instance().acquire(Budget::Queue::WORK, Budget::costOf(pending));
+    pendingFiles[pending].failures = failures;
+    this->schedule(pending, now + this->backoff(status, failures));
+  }
+
+  this->arm();
+
+  // the copies take the rest once they made room
+  if (!dueFiles.empty() && dueFiles.top().due <= now) {
+    timer.start(pressureDelay);
+  }
 }
 
 Worker::Worker(QObject *parent) : QObject(parent) {
+  // the timer is armed for the earliest due file from
+  // the thread of the worker so it has to move with it
+  timer.setParent(this);
+  timer.setSingleShot(true);
+
   // connect the timer
   connect(
     &timer, &QTimer::timeout, this, &Worker::processPendingFileUpdate
   );
 
-  // start the timer
-  timer.start(threshold);
+  // start the clock
+  clock.start();
 }
 
 /**
@@ -171,7 +493,7 @@ long long Worker::getThreshold() const {
  * @brief Set threshold
  */
 void Worker::setThreshold(long long threshold) {
-  timer.setInterval(this->threshold = threshold);
+  this->threshold = std::max<long long>(threshold, 1);
 }
 
 /**
@@ -181,12 +503,127 @@ void Worker::retry(const models::Transfer &transfer) {
   this->copy(transfer);
 }
 
+/**
+ * @brief Cancel the copies in flight, a canceled copy keeps what it
+ * has for the resume
+ */
+void Worker::cancel() {
+  copingFiles.cancel();
+}
+
+/**
+ * @brief is the destination directory a copy of the source directory,
+ * every file in it with a sidecar has to be an up to date copy of the
+ * file at the same place in the source
+ */
+bool Worker::isCopyOf(const QString &srcDir, const QString &destDir) {
+  auto flags = QDir::Files | QDir::Hidden | QDir::System;
+  QDirIterator files(destDir, flags, QDirIterator::Subdirectories);
+  QDir dest(destDir), src(srcDir);
+
+  while (files.hasNext()) {
+    auto file = files.next();
+
+    // sidecars, staged files and what never got copied
+    if (!Sidecar::load(file)) {
+      continue;
+    }
+
+    if (!Sidecar::isCopyOf(src.filePath(dest.relativeFilePath(file)), file)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Move the destination along with the renamed source, it is moved
+ * only while the old destination is a copy of the very source that was
+ * renamed as told by the file id in the sidecars, a directory is moved
+ * as a whole, a watcher that sees the move as the renames of its files
+ * too finds them in place
+ */
+bool Worker::rename(const models::Transfer &from, const models::Transfer &to) {
+  // a copy of the old name is still on its way
+  if (copingFiles.contains(from)) {
+    return false;
+  }
+
+  if (QMutexLocker locker(&pendingMutex); pendingFiles.contains(from)) {
+    return false;
+  }
+
+  auto srcInfo = QFileInfo(to.getFrom());
+  auto oldInfo = QFileInfo(from.getTo());
+
+  // moved along with its directory
+  if (!srcInfo.isDir() && Sidecar::isCopyOf(to.getFrom(), to.getTo())) {
+    return true;
+  }
+
+  // the old destination is gone or is something else by now
+  if (!oldInfo.exists() || oldInfo.isDir() != srcInfo.isDir()) {
+    return false;
+  }
+
+  if (!srcInfo.isDir() && !Sidecar::isCopyOf(to.getFrom(), from.getTo())) {
+    return false;
+  }
+
+  if (srcInfo.isDir() && !this->isCopyOf(to.getFrom(), from.getTo())) {
+    return false;
+  }
+
+  if (!QDir().mkpath(QFileInfo(to.getTo()).path())) {
+    return false;
+  }
+
+  auto oldPath = QFile::encodeName(from.getTo());
+  auto newPath = QFile::encodeName(to.getTo());
+
+#ifdef __linux__
+  // a directory never replaces what is already there
+  auto flags = srcInfo.isDir() ? RENAME_NOREPLACE : 0;
+
+  if (::renameat2(AT_FDCWD, oldPath.constData(), AT_FDCWD, newPath.constData(), flags) != 0) {
+    return false;
+  }
+#else
+  if (srcInfo.isDir() && QFileInfo::exists(to.getTo())) {
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(from.getTo().toStdWString(), to.getTo().toStdWString(), error);
+
+  if (error) {
+    return false;
+  }
+#endif
+
+  // the sidecars of a directory move with it
+  if (!srcInfo.isDir()) {
+    Sidecar::move(from.getTo(), to.getTo());
+  }
+
+  return true;
+}
+
 /**
  * @brief slot to handle file update
  */
 void Worker::handleFileUpdate(models::Transfer transfer) {
   QMutexLocker locker(&pendingMutex);
-  pendingFiles.enqueue(transfer);
-  locker.unlock();
+
+  // held in the work queue until it is copied
+  if (!pendingFiles.contains(transfer)) {
+    Budget::instance().acquire(Budget::Queue::WORK, Budget::costOf(transfer));
+  }
+
+  // a new update is tried at once and forgets the failures
+  pendingFiles[transfer].failures = 0;
+  this->schedule(transfer, clock.elapsed());
+  this->arm();
 }
 } // namespace srilakshmikanthanp::pulldog::common
@@ -9,6 +9,7 @@
 #include <QDir>
 #include <QMutex>
 #include <QMap>
+#include <QPair>
 #include <QThread>
 #include <QFileInfo>
 #include <QFile>
@@ -19,22 +20,72 @@
 #include <QDirIterator>
 #include <QMutexLocker>
 #include <QThreadPool>
+#include <QElapsedTimer>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <stdio.h>
+#endif
+
+#include <algorithm>
+#include <filesystem>
+#include <queue>
+#include <vector>
+
+#include "common/budget/budget.hpp"
 #include "common/copier/copier.hpp"
+#include "common/inflight/inflight.hpp"
+#include "common/journal/journal.hpp"
 #include "common/locker/locker.hpp"
+#include "common/metrics/metrics.hpp"
+#include "common/scheduler/scheduler.hpp"
+#include "common/sidecar/sidecar.hpp"
+#include "common/trace/trace.hpp"
+#include "models/stats/stats.hpp"
 #include "models/transfer/transfer.hpp"
 
 namespace srilakshmikanthanp::pulldog::common {
 class Worker : public QObject {
  private: // Private members
   // Currently Coping files with copier object
-  QMap<models::Transfer, common::Copier*> copingFiles;
-  QQueue<models::Transfer> pendingFiles;
+  common::InFlight copingFiles;
+  QMap<QPair<QString, QString>, QList<models::Transfer>> batches;
   QMutex pendingMutex;
-  QMutex copingMutex;
   long long threshold = 2000;
+  QElapsedTimer clock;
   QTimer timer;
 
+ private: // pending files ordered by the next attempt
+  // state of a pending file
+  struct Attempt {
+    qint64 due = 0;  // milliseconds on the clock
+    int failures = 0;
+  };
+
+  // node of the heap, stale once the due of the file moved
+  struct Due {
+    qint64 due;
+    models::Transfer transfer;
+  };
+
+  // earliest due on the top
+  struct Later {
+    bool operator()(const Due &a, const Due &b) const { return a.due > b.due; }
+  };
+
+  std::priority_queue<Due, std::vector<Due>, Later> dueFiles;
+  QMap<models::Transfer, Attempt> pendingFiles;
+
+ private: // backoff of a file that can't be copied yet
+  static inline const qint64 busyDelay = 500;
+  static inline const qint64 maxBackoff = 60000;
+  static inline const int maxDoublings = 5;
+  static inline const qint64 pressureDelay = 250;
+
+ private: // small files are copied together
+  static inline const qint64 batchThreshold = 256 << 10;
+  static inline const qsizetype batchLimit = 256;
+
  private: // Private members
   // process status
   enum CopyStatus {
@@ -42,6 +93,7 @@ class Worker : public QObject {
     Retry = -1,
     Directory = -2,
     Error = -3,
+    Busy = -4,
   };
 
  private:  // Just for qt
@@ -62,6 +114,12 @@ class Worker : public QObject {
  signals:
   void onCopyCanceled(const models::Transfer &transfer);
 
+ signals:
+  void onCopyStats(const models::Transfer &transfer, const models::TransferStats &stats);
+
+ signals:
+  void onBatchProgress(const QString &dir, int completed, int total);
+
  signals:
   void pathsChanged(const QString &path, bool isAdded);
 
@@ -69,20 +127,65 @@ class Worker : public QObject {
   void onError(const QString &error);
 
  private:
+  /**
+   * @brief Probe whether the source can be copied now
+   */
+  CopyStatus probe(const QFileInfo &srcInfo);
+
+  /**
+   * @brief is the destination directory a copy of the source directory
+   */
+  static bool isCopyOf(const QString &srcDir, const QString &destDir);
+
   /**
    * @brief Process the pending file update
    */
   CopyStatus process(const models::Transfer &transfer);
 
+  /**
+   * @brief Copy the source to all of its destinations reading it once
+   */
+  QList<CopyStatus> fanout(const QList<models::Transfer> &transfers);
+
   /**
    * @brief Slot for time process pending file update
    */
   void processPendingFileUpdate();
 
+  /**
+   * @brief Schedule the next attempt of the file, needs the lock
+   */
+  void schedule(const models::Transfer &transfer, qint64 due);
+
+  /**
+   * @brief Delay of the next attempt by the reason of the failure
+   */
+  qint64 backoff(CopyStatus status, int failures) const;
+
+  /**
+   * @brief Wake up when the earliest file is due, needs the lock
+   */
+  void arm();
+
   /**
    * @brief slot to handle file rename
    */
-  CopyStatus copy(const models::Transfer &transfer);
+  CopyStatus copy(const models::Transfer &transfer, qint64 size = -1);
+
+  /**
+   * @brief Add the small file to the batch of its directory
+   */
+  CopyStatus enqueue(const models::Transfer &transfer);
+
+  /**
+   * @brief Start a batch copier for every collected batch
+   */
+  void copyBatches();
+
+  /**
+   * @brief Forward the signals of the copier
+   */
+  void connectCopier(common::ICopier *copier);
 
  public:
   /**
@@ -110,6 +213,17 @@ class Worker : public QObject {
    */
   void retry(const models::Transfer &transfer);
 
+  /**
+   * @brief Cancel the copies in flight
+   */
+  void cancel();
+
+  /**
+   * @brief Move the destination along with the renamed source, returns
+   * false when the destination no longer matches and has to be copied
+   */
+  bool rename(const models::Transfer &from, const models::Transfer &to);
+
   /**
    * @brief slot to handle file update
    */
@@ -7,89 +7,417 @@
 
 namespace srilakshmikanthanp::pulldog {
 /**
- * @brief slot to handle file update
+ * @brief Destinations of the file under the watch root, the route of
+ * the file or the destination root first and the mirrors of the watch
+ * root after it
+ */
+QStringList Controller::destinationsOf(const QString &root, const QString &path) {
+  auto routed = router.resolve(QDir(root).filePath(path));
+
+  QMutexLocker locker(&mirrorMutex);
+  QStringList destinations{routed.value_or(destinationRoot.filePath(path))};
+
+  for (const auto &mirror : mirrors.value(root)) {
+    destinations.append(QDir(mirror).filePath(path));
+  }
+
+  return destinations;
+}
+
+/**
+ * @brief slot to handle file update, the file goes to every destination
+ * of its root as a transfer of its own so each has its own state
  */
 void Controller::handleFileUpdate(const QString dir, const QString path) {
-  // get the destination file path from the destination root
-  auto destFile = QDir(destinationRoot).filePath(path);
+  PULLDOG_TRACE_SPAN("Controller::handleFileUpdate");
+
+  // the journal has the rest once drained
+  if (draining) {
+    return;
+  }
+
+  // source file path from the watch root
   auto srcFile = QDir(dir).filePath(path);
+  QList<models::Transfer> transfers;
 
-  // Create a key for the pending file update
-  auto transfer = models::Transfer(srcFile, destFile);
+  for (const auto &destFile : this->destinationsOf(dir, path)) {
+    // Create a key for the pending file update
+    auto transfer = models::Transfer(srcFile, destFile);
 
-  // add it to events
-  QMetaObject::invokeMethod(
-    &worker, [=] { worker.handleFileUpdate(transfer); }
-  );
+    // written ahead so a restart picks it up again
+    common::Journal::instance().queued(transfer);
+    common::Metrics::instance().detected(transfer);
+
+    // held in the watch queue until the worker takes it
+    common::Budget::instance().acquire(
+      common::Budget::Queue::WATCH, common::Budget::costOf(transfer)
+    );
+
+    transfers.append(transfer);
+  }
+
+  // the worker gets them together once the writer is done
+  QMetaObject::invokeMethod(&readiness, [=] {
+    for (const auto &transfer : transfers) {
+      readiness.track(transfer);
+    }
+  });
 }
 
 /**
- * @brief Handle the file rename
+ * @brief Handle the file rename, the destination is renamed on the
+ * worker thread so it is ordered with the copies, it is copied only if
+ * the old destination doesn't match the source anymore
  */
 void Controller::handleFileRename(
   const QString directory,
   const QString oldFile,
   const QString newFile
 ) {
-  this->handleFileUpdate(directory, newFile);
+  PULLDOG_TRACE_SPAN("Controller::handleFileRename");
+
+  // the journal has the rest once drained
+  if (draining) {
+    return;
+  }
+
+  auto oldDests = this->destinationsOf(directory, oldFile);
+  auto newDests = this->destinationsOf(directory, newFile);
+
+  for (qsizetype i = 0; i < newDests.size(); ++i) {
+    // a file routed elsewhere by its new name is moved across
+    auto from = models::Transfer(
+      QDir(directory).filePath(oldFile), oldDests.value(i, newDests[i])
+    );
+
+    auto to = models::Transfer(
+      QDir(directory).filePath(newFile), newDests[i]
+    );
+
+    // written ahead like any other update
+    common::Journal::instance().queued(to);
+    common::Metrics::instance().detected(to);
+
+    // held in the watch queue until it is moved or copied
+    common::Budget::instance().acquire(
+      common::Budget::Queue::WATCH, common::Budget::costOf(to)
+    );
+
+    QMetaObject::invokeMethod(&worker, [=] {
+      if (!worker.rename(from, to)) {
+        return this->copyRenamed(to);
+      }
+
+      common::Budget::instance().release(
+        common::Budget::Queue::WATCH, common::Budget::costOf(to)
+      );
+
+      common::Journal::instance().committed(to);
+      common::Metrics::instance().committed(to);
+    });
+  }
+}
+
+/**
+ * @brief Copy what couldn't be moved, the files of a directory are
+ * copied one by one into the place the move would have put them since
+ * not every watcher reports them on a directory move, on the worker
+ * thread
+ */
+void Controller::copyRenamed(const models::Transfer &to) {
+  readiness.track(to);
+
+  if (!QFileInfo(to.getFrom()).isDir()) {
+    return;
+  }
+
+  auto flags = QDir::Files | QDir::Hidden | QDir::System;
+  QDirIterator files(to.getFrom(), flags, QDirIterator::Subdirectories);
+  QDir src(to.getFrom()), dest(to.getTo());
+
+  while (files.hasNext()) {
+    auto file     = files.next();
+    auto transfer = models::Transfer(file, dest.filePath(src.relativeFilePath(file)));
+
+    // written ahead like any other update
+    common::Journal::instance().queued(transfer);
+    common::Metrics::instance().detected(transfer);
+
+    // held in the watch queue until the worker takes it
+    common::Budget::instance().acquire(
+      common::Budget::Queue::WATCH, common::Budget::costOf(transfer)
+    );
+
+    readiness.track(transfer);
+  }
+}
+
+/**
+ * @brief Queue the event for the ui, the event queue is bounded by the
+ * budget and a droppable event is dropped once it is full, the others
+ * are bounded by the transfers in the pipeline
+ */
+bool Controller::post(Event event, bool droppable) {
+  using common::Budget;
+
+  // the ui no longer makes room once the controller is going away
+  if (closing) {
+    return false;
+  }
+
+  if (droppable && !Budget::instance().tryAcquire(Budget::Queue::EVENT, event.cost)) {
+    return false;
+  }
+
+  if (!droppable) {
+    Budget::instance().acquire(Budget::Queue::EVENT, event.cost);
+  }
+
+  // an event that can't be dropped goes over the budget so the ring
+  // can fill up, a producer then sleeps until the ui made room while
+  // the ui thread itself makes room by delivering the oldest in order
+  while (!events.push(event)) {
+    if (QThread::currentThread() == this->thread()) {
+      if (Event older; events.pop(older)) {
+        this->deliver(older);
+      }
+
+      continue;
+    }
+
+    QMutexLocker locker(&roomMutex);
+
+    if (closing) {
+      Budget::instance().release(Budget::Queue::EVENT, event.cost);
+      return false;
+    }
+
+    // the ui wakes the room under the lock after it popped, so
+    // a pop can't slip in between this push and the wait
+    if (events.push(event)) {
+      break;
+    }
+
+    this->wake();
+    room.wait(&roomMutex);
+  }
+
+  this->wake();
+
+  return true;
+}
+
+/**
+ * @brief Get the ui thread to deliver the events unless it is about
+ * to, an idle controller has nothing running until the next event
+ */
+void Controller::wake() {
+  if (!waking.exchange(true)) {
+    QMetaObject::invokeMethod(this, &Controller::processEvents, Qt::QueuedConnection);
+  }
+}
+
+/**
+ * @brief Deliver the event to the ui, a progress carries the latest
+ * value reported since it was queued
+ */
+void Controller::deliver(const Event &event) {
+  using Type = Event::Type;
+
+  switch (event.type) {
+  case Type::START:
+    emit onCopyStart(event.transfer);
+    break;
+  case Type::PROGRESS: {
+    QMutexLocker locker(&coalesceMutex);
+    auto value = progress.take(event.transfer);
+    locker.unlock();
+    emit onCopy(event.transfer, value);
+    break;
+  }
+  case Type::END:
+    emit onCopyEnd(event.transfer);
+    break;
+  case Type::CANCELED:
+    emit onCopyCanceled(event.transfer);
+    break;
+  case Type::FAILED:
+    emit onCopyFailed(event.transfer, event.error);
+    break;
+  case Type::STATS:
+    emit onCopyStats(event.transfer, event.stats);
+    break;
+  case Type::BATCH: {
+    QMutexLocker locker(&coalesceMutex);
+    auto [completed, total] = batchProgress.take(event.dir);
+    locker.unlock();
+    emit onBatchProgress(event.dir, completed, total);
+    break;
+  }
+  }
+
+  common::Budget::instance().release(common::Budget::Queue::EVENT, event.cost);
 }
 
 /**
  * @brief Handle the copy start
  */
 void Controller::handleCopyStart(const models::Transfer &transfer) {
-  QMutexLocker locker(&eventMutex);
-  this->events.enqueue([=] { emit onCopyStart(transfer); });
+  common::Journal::instance().started(transfer);
+  common::Metrics::instance().started(transfer);
+  this->post(Event{Event::Type::START, transfer, {}, {}, 0, common::Budget::costOf(transfer)});
 }
 
 /**
- * @brief Handle the copy
+ * @brief Handle the copy, a transfer has at most one progress queued
+ * which is updated in place until the ui takes it
  */
-void Controller::handleCopy(const models::Transfer &transfer, double progress) {
-  QMutexLocker locker(&eventMutex);
-  this->events.enqueue([=] { emit onCopy(transfer, progress); });
+void Controller::handleCopy(const models::Transfer &transfer, double value) {
+  QMutexLocker locker(&coalesceMutex);
+
+  if (auto pending = progress.find(transfer); pending != progress.end()) {
+    *pending = value;
+    return;
+  }
+
+  progress.insert(transfer, value);
+  locker.unlock();
+
+  // a lost progress is made up by the next one
+  if (!this->post(Event{Event::Type::PROGRESS, transfer, {}, {}, 0, common::Budget::costOf(transfer)}, true)) {
+    locker.relock();
+    progress.remove(transfer);
+  }
 }
 
 /**
  * @brief Handle the copy end
  */
 void Controller::handleCopyEnd(const models::Transfer &transfer) {
-  QMutexLocker locker(&eventMutex);
-  this->events.enqueue([=] { emit onCopyEnd(transfer); });
+  common::Journal::instance().committed(transfer);
+  common::Metrics::instance().committed(transfer);
+  this->post(Event{Event::Type::END, transfer, {}, {}, 0, common::Budget::costOf(transfer)});
 }
 
 /**
- * @brief Handle the copy canceled
+ * @brief Handle the copy canceled, a canceled copy is superseded
+ * by a newer one so the transfer is still queued
  */
 void Controller::handleCopyCanceled(const models::Transfer &transfer) {
-  QMutexLocker locker(&eventMutex);
-  this->events.enqueue([=] { emit onCopyCanceled(transfer); });
+  common::Journal::instance().queued(transfer);
+  this->post(Event{Event::Type::CANCELED, transfer, {}, {}, 0, common::Budget::costOf(transfer)});
 }
 
 /**
  * @brief Handle the copy failed
  */
 void Controller::handleCopyFailed(const models::Transfer &transfer, int error) {
-  QMutexLocker locker(&eventMutex);
-  this->events.enqueue([=] { emit onCopyFailed(transfer, error); });
+  common::Journal::instance().failed(transfer, error);
+  common::Metrics::instance().failed(transfer);
+  this->post(Event{Event::Type::FAILED, transfer, {}, {}, error, common::Budget::costOf(transfer)});
 }
 
 /**
- * @brief Process the events
+ * @brief Handle the copy stats
+ */
+void Controller::handleCopyStats(const models::Transfer &transfer, const models::TransferStats &stats) {
+  common::Metrics::instance().count(common::Metrics::Counter::THROTTLED, stats.throttled);
+  this->post(Event{Event::Type::STATS, transfer, stats, {}, 0, common::Budget::costOf(transfer)});
+}
+
+/**
+ * @brief Handle the progress of a batch of small files, coalesced
+ * per directory like the progress of a transfer
+ */
+void Controller::handleBatchProgress(const QString &dir, int completed, int total) {
+  QMutexLocker locker(&coalesceMutex);
+
+  if (auto pending = batchProgress.find(dir); pending != batchProgress.end()) {
+    *pending = qMakePair(completed, total);
+    return;
+  }
+
+  batchProgress.insert(dir, qMakePair(completed, total));
+  locker.unlock();
+
+  auto cost = static_cast<qint64>(dir.size() * sizeof(QChar) + 64);
+
+  if (!this->post(Event{Event::Type::BATCH, models::Transfer({}, {}), {}, dir, 0, cost}, true)) {
+    locker.relock();
+    batchProgress.remove(dir);
+  }
+}
+
+/**
+ * @brief Replay the journal, the transfers that were queued or copying
+ * go through the pipeline again and the failures are reported again
+ */
+void Controller::resume() {
+  for (const auto &transfer : common::Journal::instance().pending()) {
+    common::Budget::instance().acquire(
+      common::Budget::Queue::WATCH, common::Budget::costOf(transfer)
+    );
+
+    QMetaObject::invokeMethod(
+      &readiness, [=] { readiness.track(transfer); }
+    );
+  }
+
+  // the failures are reported a frame at a time once the loop runs
+  replayed = common::Journal::instance().failures();
+
+  if (!replayed.isEmpty()) {
+    QMetaObject::invokeMethod(this, &Controller::replayFailures, Qt::QueuedConnection);
+  }
+}
+
+/**
+ * @brief Report a frame of the failures of the last run, the rest
+ * follows after the ui had its turn so a long journal never floods
+ * the event ring
+ */
+void Controller::replayFailures() {
+  for (int i = 0; i < parallelEvents && !replayed.isEmpty(); i++) {
+    auto [transfer, error] = replayed.takeFirst();
+    this->handleCopyFailed(transfer, error);
+  }
+
+  if (!replayed.isEmpty()) {
+    QMetaObject::invokeMethod(this, &Controller::replayFailures, Qt::QueuedConnection);
+  }
+}
+
+/**
+ * @brief Deliver a frame of events, while events keep coming the frames
+ * follow each other at the frame interval, once the ring is empty the
+ * controller sleeps until the next event wakes it
  */
 void Controller::processEvents() {
-  // lock the mutex and process the events
-  QMutexLocker locker(&eventMutex);
+  PULLDOG_TRACE_SPAN("Controller::processEvents");
+
+  Event event;
+  int delivered = 0;
 
-  // process the events in parallel
-  for (int i = 0; i < parallelEvents && !events.isEmpty(); i++) {
-    events.dequeue()();
+  for (; delivered < parallelEvents && events.pop(event); delivered++) {
+    this->deliver(event);
   }
 
-  // process the events in interval
-  QTimer::singleShot(
-    0, this, &Controller::processEvents
-  );
+  // producers waiting on a full ring have room now
+  if (delivered > 0) {
+    QMutexLocker locker(&roomMutex);
+    room.wakeAll();
+  }
+
+  if (!events.isEmpty()) {
+    return eventProcessor.start();
+  }
+
+  // an event pushed before the flag is cleared would be missed
+  waking.store(false);
+
+  if (!events.isEmpty() && !waking.exchange(true)) {
+    eventProcessor.start();
+  }
 }
 
 /**
@@ -129,13 +457,44 @@ Controller::Controller(QObject *parent) : QObject(parent) {
     Qt::DirectConnection
   );
 
+  connect(
+    &worker, &common::Worker::onCopyStats,
+    this, &Controller::handleCopyStats,
+    Qt::DirectConnection
+  );
+
+  connect(
+    &worker, &common::Worker::onBatchProgress,
+    this, &Controller::handleBatchProgress,
+    Qt::DirectConnection
+  );
+
   connect(
     &worker, &common::Worker::onError,
     this, &Controller::onError
   );
 
+  connect(
+    &exporter, &common::Exporter::onError,
+    this, &Controller::onError
+  );
+
+  // the time it took the writer, before the worker starts it
+  connect(
+    &readiness, &common::Readiness::fileReady,
+    [](const models::Transfer &transfer) { common::Metrics::instance().ready(transfer); }
+  );
+
+  // ready files go to the worker on the same thread
+  connect(
+    &readiness, &common::Readiness::fileReady,
+    &worker, &common::Worker::handleFileUpdate,
+    Qt::DirectConnection
+  );
+
   // move the worker to the thread
   worker.moveToThread(&workerThread);
+  readiness.moveToThread(&workerThread);
 
   // start the worker thread
   workerThread.start();
@@ -180,18 +539,40 @@ Controller::Controller(QObject *parent) : QObject(parent) {
   // start
   watcherThread.start();
 
-  // single shot timer to process the events
-  QTimer::singleShot(0, this, &Controller::processEvents);
+  // frames of events are delivered at most once per interval
+  eventProcessor.setParent(this);
+  eventProcessor.setSingleShot(true);
+  eventProcessor.setInterval(interval);
+
+  connect(
+    &eventProcessor, &QTimer::timeout,
+    this, &Controller::processEvents
+  );
+
+  // pick up where the last run left off
+  this->resume();
 }
 
 /**
- * @brief Destroy the Controller object
+ * @brief Destroy the Controller object, the copies are canceled and
+ * drained here since the scheduler is only destroyed with the statics
  */
 Controller::~Controller() {
+  // nobody delivers the events any more, the producers
+  // waiting for room give up their events
+  closing = true;
+  roomMutex.lock();
+  room.wakeAll();
+  roomMutex.unlock();
+
   for(auto thread: {&watcherThread, &workerThread}) {
     thread->quit();
     thread->wait();
   }
+
+  // the copies end while the singletons they use are alive
+  worker.cancel();
+  common::Scheduler::instance().shutdown();
 }
 
 /**
@@ -205,9 +586,42 @@ QString Controller::getDestinationRoot() const {
  * @brief set the destination root
  */
 void Controller::setDestinationRoot(const QString &path) {
+  QMutexLocker locker(&mirrorMutex);
   destinationRoot = QDir(path);
 }
 
+/**
+ * @brief Set the mirrors, the destination roots a watch root is
+ * copied to besides the destination root
+ */
+void Controller::setMirrors(const QMap<QString, QStringList> &mirrors) {
+  QMutexLocker locker(&mirrorMutex);
+  this->mirrors = mirrors;
+}
+
+/**
+ * @brief Set the routes, the first of the deepest matching routes
+ * decides where a file goes instead of the destination root
+ */
+void Controller::setRoutes(const QList<common::Router::Route> &routes) {
+  router.setRoutes(routes);
+}
+
+/**
+ * @brief Get the routes
+ */
+QList<common::Router::Route> Controller::getRoutes() const {
+  return router.getRoutes();
+}
+
+/**
+ * @brief Get the mirrors
+ */
+QMap<QString, QStringList> Controller::getMirrors() {
+  QMutexLocker locker(&mirrorMutex);
+  return mirrors;
+}
+
 /**
  * @brief Get threshold
  */
@@ -222,6 +636,20 @@ void Controller::setWorkerThreshold(long long threshold) {
   worker.setThreshold(threshold);
 }
 
+/**
+ * @brief Set how long a file must stay unchanged before it is copied
+ */
+void Controller::setQuietWindow(qint64 window) {
+  readiness.setQuietWindow(window);
+}
+
+/**
+ * @brief Get how long a file must stay unchanged before it is copied
+ */
+qint64 Controller::getQuietWindow() const {
+  return readiness.getQuietWindow();
+}
+
 /**
  * @brief set the parallel events
  */
@@ -261,6 +689,65 @@ void Controller::addWatchPath(const QString &path, bool recursive) {
   );
 }
 
+/**
+ * @brief Set the global bandwidth limit in bytes per second
+ */
+void Controller::setBandwidthLimit(qint64 rate) {
+  common::Governor::instance().setLimit(rate);
+}
+
+/**
+ * @brief Get the global bandwidth limit in bytes per second
+ */
+qint64 Controller::getBandwidthLimit() const {
+  return common::Governor::instance().getLimit();
+}
+
+/**
+ * @brief Set the global bandwidth schedule
+ */
+void Controller::setBandwidthSchedule(const QList<common::Governor::Window> &schedule) {
+  common::Governor::instance().setSchedule(schedule);
+}
+
+/**
+ * @brief Set the bandwidth limit of a watch path
+ */
+void Controller::setWatchBandwidthLimit(const QString &path, qint64 rate) {
+  common::Governor::instance().setRootLimit(path, rate);
+}
+
+/**
+ * @brief Set the bandwidth schedule of a watch path
+ */
+void Controller::setWatchBandwidthSchedule(
+  const QString &path,
+  const QList<common::Governor::Window> &schedule
+) {
+  common::Governor::instance().setRootSchedule(path, schedule);
+}
+
+/**
+ * @brief Enable or disable the dedup of identical files
+ */
+void Controller::setDedupEnabled(bool enabled) {
+  common::Dedup::instance().setEnabled(enabled);
+}
+
+/**
+ * @brief Set how dedup candidates are confirmed
+ */
+void Controller::setDedupConfirm(common::Dedup::Confirm confirm) {
+  common::Dedup::instance().setConfirm(confirm);
+}
+
+/**
+ * @brief Set the rules that put copies into priority classes
+ */
+void Controller::setSchedulerRules(const QList<common::Scheduler::Rule> &rules) {
+  common::Scheduler::instance().setRules(rules);
+}
+
 /**
  * @brief Get the Paths object
  */
@@ -272,6 +759,7 @@ QStringList Controller::watchPaths() const {
  * @brief Retry a transfer
  */
 void Controller::retry(const models::Transfer &transfer) {
+  common::Journal::instance().queued(transfer);
   QMetaObject::invokeMethod(
     &worker, [=] { this->worker.retry(transfer); }
   );
@@ -281,8 +769,41 @@ void Controller::retry(const models::Transfer &transfer) {
  * @brief Remove a path from watch
  */
 void Controller::removeWatchPath(const QString &path) {
+  common::Governor::instance().removeRoot(path);
   QMetaObject::invokeMethod(
     &watcher, [=] { this->watcher.removePath(path); }
   );
 }
+
+/**
+ * @brief Serve the metrics on unix:PATH, HOST:PORT or PORT of the
+ * loopback, an empty address stops serving them
+ */
+void Controller::setMetricsAddress(const QString &address) {
+  exporter.listen(address);
+}
+
+/**
+ * @brief Stop taking changes of the watched paths, the transfers
+ * already taken go on to the end
+ */
+void Controller::drain() {
+  draining = true;
+}
+
+/**
+ * @brief has every transfer taken been moved, copied or failed, the
+ * events for the ui don't hold it back
+ */
+bool Controller::isDrained() const {
+  using common::Budget;
+
+  for (auto queue : {Budget::Queue::WATCH, Budget::Queue::WORK, Budget::Queue::COPY}) {
+    if (Budget::instance().items(queue)) {
+      return false;
+    }
+  }
+
+  return true;
+}
 }  // namespace srilakshmikanthanp::pulldog
@@ -9,43 +9,90 @@
 #include <QDir>
 #include <QMutex>
 #include <QMap>
+#include <QHash>
+#include <QPair>
 #include <QThread>
 #include <QFileInfo>
 #include <QFile>
 #include <QList>
+#include <QStringList>
 #include <QSharedPointer>
 #include <QTimer>
 #include <QDirIterator>
+#include <QWaitCondition>
 
+#include "common/budget/budget.hpp"
 #include "common/copier/copier.hpp"
+#include "common/dedup/dedup.hpp"
+#include "common/governor/governor.hpp"
+#include "common/journal/journal.hpp"
+#include "common/scheduler/scheduler.hpp"
 #include "common/locker/locker.hpp"
+#include "common/metrics/exporter.hpp"
+#include "common/metrics/metrics.hpp"
+#include "common/readiness/readiness.hpp"
+#include "common/ring/ring.hpp"
+#include "common/router/router.hpp"
+#include "common/trace/trace.hpp"
 #include "common/watch/watch.hpp"
 #include "common/worker/worker.hpp"
+#include "models/stats/stats.hpp"
 #include "models/transfer/transfer.hpp"
 #include "store/storage.hpp"
 
 namespace srilakshmikanthanp::pulldog {
 class Controller : public QObject {
+ private: // event for the ui
+  struct Event {
+    enum class Type : quint8 {
+      START, PROGRESS, END, CANCELED, FAILED, STATS, BATCH,
+    };
+
+    Type type = Type::START;
+    models::Transfer transfer = models::Transfer({}, {});
+    models::TransferStats stats;
+    QString dir;
+    int error = 0;
+    qint64 cost = 0;
+  };
+
+ private: // Private members
+  static inline const size_t eventCapacity = 16384;  // items of the event queue
+
  private: // Private members
-  QQueue<std::function<void()>> events;
-  QMutex eventMutex;
+  common::Ring<Event, eventCapacity> events;
+  QMap<models::Transfer, double> progress;        // latest of an undelivered progress
+  QHash<QString, QPair<int, int>> batchProgress;  // latest of an undelivered batch
+  QMutex coalesceMutex;
+  QMutex roomMutex;
+  QWaitCondition room;  // the ui popped events off a full ring
+  std::atomic<bool> waking = false;
+  QList<QPair<models::Transfer, int>> replayed;  // failures of the last run
 
  private: // Private members
-  std::atomic<int> parallelEvents = 25;
-  std::atomic<int> interval = 1000;
+  std::atomic<int> parallelEvents = 1024;  // events per frame
+  std::atomic<int> interval = 33;          // ms per frame
 
  private: // Private members
   common::Watch watcher;
   QThread watcherThread;
   QDir destinationRoot;
+  QMap<QString, QStringList> mirrors;  // more destination roots of a watch root
+  QMutex mirrorMutex;
+  common::Router router;
+  common::Readiness readiness;
   common::Worker worker;
   QThread workerThread;
   QTimer eventProcessor;
+  common::Exporter exporter;
+  std::atomic<bool> draining = false;  // changes are no longer taken
+  std::atomic<bool> closing  = false;  // events are no longer delivered
 
  private:  // Just for qt
   Q_OBJECT
 
  private:  // slots
+  QStringList destinationsOf(const QString &root, const QString &path);
   void handleFileUpdate(const QString dir, const QString path);
 
  private:
@@ -55,15 +102,24 @@ class Controller : public QObject {
     const QString newFile
   );
 
+  void copyRenamed(const models::Transfer &to);
+
  private: // handlers
+  bool post(Event event, bool droppable = false);
+  void wake();
+  void deliver(const Event &event);
   void handleCopyStart(const models::Transfer &transfer);
-  void handleCopy(const models::Transfer &transfer, double progress);
+  void handleCopy(const models::Transfer &transfer, double value);
   void handleCopyEnd(const models::Transfer &transfer);
   void handleCopyCanceled(const models::Transfer &transfer);
   void handleCopyFailed(const models::Transfer &transfer, int error);
+  void handleCopyStats(const models::Transfer &transfer, const models::TransferStats &stats);
+  void handleBatchProgress(const QString &dir, int completed, int total);
 
  private:  // Private members
   void processEvents();
+  void resume();
+  void replayFailures();
 
  signals:
   void onCopyStart(const models::Transfer &transfer);
@@ -80,6 +136,12 @@ class Controller : public QObject {
  signals:
   void onCopyFailed(const models::Transfer &transfer, int error);
 
+ signals:
+  void onCopyStats(const models::Transfer &transfer, const models::TransferStats &stats);
+
+ signals:
+  void onBatchProgress(const QString &dir, int completed, int total);
+
  signals:
   void pathAdded(const QString &path);
 
@@ -113,6 +175,27 @@ class Controller : public QObject {
    */
   void setDestinationRoot(const QString &path);
 
+  /**
+   * @brief Set the destination roots a watch root is mirrored to
+   * besides the destination root
+   */
+  void setMirrors(const QMap<QString, QStringList> &mirrors);
+
+  /**
+   * @brief Get the mirrors of the watch roots
+   */
+  QMap<QString, QStringList> getMirrors();
+
+  /**
+   * @brief Set the routes of the files to their destinations
+   */
+  void setRoutes(const QList<common::Router::Route> &routes);
+
+  /**
+   * @brief Get the routes of the files to their destinations
+   */
+  QList<common::Router::Route> getRoutes() const;
+
   /**
    * @brief Get threshold
    */
@@ -143,6 +226,62 @@ class Controller : public QObject {
    */
   int getProcessInterval() const;
 
+  /**
+   * @brief Set the global bandwidth limit in bytes per second
+   */
+  void setBandwidthLimit(qint64 rate);
+
+  /**
+   * @brief Get the global bandwidth limit in bytes per second
+   */
+  qint64 getBandwidthLimit() const;
+
+  /**
+   * @brief Set the global bandwidth schedule
+   */
+  void setBandwidthSchedule(const QList<common::Governor::Window> &schedule);
+
+  /**
+   * @brief Set the bandwidth limit of a watch path
+   */
+  void setWatchBandwidthLimit(const QString &path, qint64 rate);
+
+  /**
+   * @brief Set the bandwidth schedule of a watch path
+   */
+  void setWatchBandwidthSchedule(const QString &path, const QList<common::Governor::Window> &schedule);
+
+  /**
+   * @brief Enable or disable the dedup of identical files
+   */
+  void setDedupEnabled(bool enabled);
+
+  /**
+   * @brief Set how dedup candidates are confirmed
+   */
+  void setDedupConfirm(common::Dedup::Confirm confirm);
+
+  /**
+   * @brief Set the rules that put copies into priority classes
+   */
+  void setSchedulerRules(const QList<common::Scheduler::Rule> &rules);
+
+  /**
+   * @brief Set how long a file must stay unchanged before it is copied
+   */
+  void setQuietWindow(qint64 window);
+
+  /**
+   * @brief Get how long a file must stay unchanged before it is copied
+   */
+  qint64 getQuietWindow() const;
+
+  /**
+   * @brief Serve the metrics on unix:PATH, HOST:PORT or PORT of the
+   * loopback, an empty address stops serving them
+   */
+  void setMetricsAddress(const QString &address);
+
   /**
    * @brief Get the Paths object
    */
@@ -162,5 +301,16 @@ class Controller : public QObject {
    * @brief Add a path to watch
    */
   void addWatchPath(const QString &path, bool recursive = true);
+
+  /**
+   * @brief Stop taking changes of the watched paths, the transfers
+   * already taken go on to the end
+   */
+  void drain();
+
+  /**
+   * @brief has every transfer taken been moved, copied or failed
+   */
+  bool isDrained() const;
 };
 }  // namespace srilakshmikanthanp::pulldog
@@ -0,0 +1,355 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QLockFile>
+#include <QSocketNotifier>
+#include <QTextStream>
+#include <QTimer>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <csignal>
+
+#include "constants/constants.hpp"
+#include "controller/controller.hpp"
+#include "common/trace/trace.hpp"
+#include "store/storage.hpp"
+#include "utility/logging/logging.hpp"
+
+namespace srilakshmikanthanp::pulldog {
+/**
+ * @brief Headless application that drives the controller from the
+ * settings of the user, an ini file or the flags without any ui, a
+ * termination signal drains the transfers already taken before quit
+ * and SIGUSR1 writes out the trace spans
+ */
+class PullDogDaemon : public QCoreApplication {
+ private:  // Member Functions
+#ifndef _WIN32
+  // write end of the pipe the signal handler wakes the loop through
+  static inline int signalFd = -1;
+
+  /**
+   * @brief Signal handler, only async signal safe calls
+   */
+  static void onSignal(int sig) {
+    char byte = static_cast<char>(sig);
+    auto wrote = ::write(signalFd, &byte, sizeof(byte));
+    (void) wrote;
+  }
+#endif
+
+  /**
+   * @brief Drain the transfers on the first signal and quit at once
+   * on the second, the journal has whatever is left at the deadline
+   */
+  void onTerminate() {
+    if (deadline.isForever()) {
+      qInfo() << "Draining the transfers";
+      deadline.setRemainingTime(drainTimeout);
+      controller->drain();
+      drainer->start();
+    } else {
+      qInfo() << "Quitting without draining";
+      quit();
+    }
+  }
+
+  /**
+   * @brief Write the spans to the home of the app
+   */
+  void dumpTrace() {
+    auto file = QDir(QString::fromStdString(constants::getAppHome())).filePath("pulldogd.trace.json");
+
+    if (common::Tracer::instance().dump(file)) {
+      qInfo() << "Trace written to" << file;
+    } else {
+      qWarning() << "Can't write the trace to" << file;
+    }
+  }
+
+  /**
+   * @brief Quit once drained or the deadline passed
+   */
+  void checkDrained() {
+    if (controller->isDrained() || deadline.hasExpired()) {
+      quit();
+    }
+  }
+
+ private:  //  Member Variables and Objects
+
+  static inline const int drainInterval = 100;  // ms between the checks
+
+ private:  //  Member Variables and Objects
+
+  Controller *controller;
+  QTimer *drainer;
+  QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever);
+  qint64 drainTimeout = 30000;  // ms to wait for the transfers
+#ifndef _WIN32
+  QSocketNotifier *notifier = nullptr;
+  int fds[2] = {-1, -1};
+#endif
+
+ private:  // Disable Copy, Move and Assignment
+
+  Q_DISABLE_COPY_MOVE(PullDogDaemon);
+
+ public:  // Constructors and Destructors
+
+  /**
+   * @brief Construct a new PullDog Daemon object
+   *
+   * @param argc argument count
+   * @param argv argument vector
+   */
+  PullDogDaemon(int &argc, char **argv) : QCoreApplication(argc, argv) {
+    controller = nullptr;
+    drainer    = new QTimer(this);
+    drainer->setInterval(drainInterval);
+
+    // check the drain in interval
+    connect(drainer, &QTimer::timeout, this, &PullDogDaemon::checkDrained);
+
+#ifndef _WIN32
+    // the loop is woken through a pipe, nothing else is safe in a handler
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0) {
+      signalFd = fds[0];
+      notifier = new QSocketNotifier(fds[1], QSocketNotifier::Read, this);
+
+      connect(notifier, &QSocketNotifier::activated, [this] {
+        char byte;
+        auto read = ::read(fds[1], &byte, sizeof(byte));
+        (void) read;
+        byte == SIGUSR1 ? dumpTrace() : onTerminate();
+      });
+
+      struct sigaction action = {};
+      action.sa_handler = &PullDogDaemon::onSignal;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+
+      sigaction(SIGTERM, &action, nullptr);
+      sigaction(SIGINT, &action, nullptr);
+      sigaction(SIGUSR1, &action, nullptr);
+    }
+#else
+    // set the signal handler for windows
+    signal(SIGTERM, [](int sig) { qApp->quit(); });
+    signal(SIGINT, [](int sig) { qApp->quit(); });
+#endif
+  }
+
+  /**
+   * @brief Destroy the PullDog Daemon Object and it's members
+   */
+  virtual ~PullDogDaemon() {
+    delete controller;
+#ifndef _WIN32
+    for (auto fd : fds) {
+      if (fd != -1) {
+        ::close(fd);
+      }
+    }
+#endif
+  }
+
+  /**
+   * @brief Start the controller with the settings and the flags,
+   * a flag wins over the setting
+   */
+  void start(const QCommandLineParser &parser) {
+    // Storage Instance
+    auto storage = &storage::Storage::instance();
+
+    // settings from the ini file
+    if (parser.isSet("config")) {
+      storage->setFile(parser.value("config"));
+    }
+
+    // time to wait for the transfers
+    if (parser.isSet("drain-timeout")) {
+      drainTimeout = parser.value("drain-timeout").toLongLong() * 1000;
+    }
+
+    // create the controller after the home exists
+    controller = new Controller();
+
+    // controller on error signal to log
+    connect(
+      controller, &Controller::onError,
+      [](const QString &error) { qCritical() << error; }
+    );
+
+    // failed transfers are only logged without a ui
+    connect(
+      controller, &Controller::onCopyFailed,
+      [](const models::Transfer &transfer, int error) {
+        qWarning() << "Copy failed" << transfer.getFrom() << transfer.getTo() << error;
+      }
+    );
+
+    // set destination root
+    controller->setDestinationRoot(
+      parser.isSet("dest") ? parser.value("dest") : storage->getDownloadPath()
+    );
+
+    // set bandwidth limits
+    controller->setBandwidthLimit(
+      parser.isSet("bandwidth") ? parser.value("bandwidth").toLongLong() : storage->getBandwidthLimit()
+    );
+    controller->setBandwidthSchedule(
+      common::Governor::Window::listFromStrings(storage->getBandwidthSchedule())
+    );
+
+    // set bandwidth limits of the watch paths
+    auto limits = storage->getWatchBandwidthLimits();
+    for (auto it = limits.cbegin(); it != limits.cend(); ++it) {
+      controller->setWatchBandwidthLimit(it.key(), it.value());
+    }
+
+    auto schedules = storage->getWatchBandwidthSchedules();
+    for (auto it = schedules.cbegin(); it != schedules.cend(); ++it) {
+      controller->setWatchBandwidthSchedule(it.key(), common::Governor::Window::listFromStrings(it.value()));
+    }
+
+    // set dedup of identical files
+    using Confirm = common::Dedup::Confirm;
+    controller->setDedupEnabled(storage->getDedupEnabled());
+    controller->setDedupConfirm(storage->getDedupConfirm() == "sampled" ? Confirm::SAMPLED : Confirm::FULL);
+
+    // scheduler rules from the storage
+    QList<common::Scheduler::Rule> rules;
+    for (const auto &rule : storage->getSchedulerRules()) {
+      rules.append(common::Scheduler::Rule::fromString(rule));
+    }
+
+    // set scheduler rules
+    controller->setSchedulerRules(rules);
+
+    // set the quiet window of written files
+    controller->setQuietWindow(
+      parser.isSet("quiet") ? parser.value("quiet").toLongLong() : storage->getQuietWindow()
+    );
+
+    // set the mirrors of the watch roots
+    controller->setMirrors(storage->getMirrors());
+
+    // routes from the storage
+    QList<common::Router::Route> routes;
+    for (const auto &route : storage->getRoutes()) {
+      routes.append(common::Router::Route::fromString(route));
+    }
+
+    // set the routes of the files
+    controller->setRoutes(routes);
+
+    // serve the metrics if asked for
+    controller->setMetricsAddress(
+      parser.isSet("metrics") ? parser.value("metrics") : storage->getMetricsAddress()
+    );
+
+    // set watch list, the flags replace the stored ones
+    auto paths = parser.isSet("watch") ? parser.values("watch") : storage->getPaths();
+
+    for (const auto &path : paths) {
+      controller->addWatchPath(path);
+    }
+  }
+};
+} // namespace srilakshmikanthanp::pulldog
+
+/**
+ * @brief Global Error Handler that helps to log
+ */
+void globalErrorHandler() {
+  try {
+    std::rethrow_exception(std::current_exception());
+  } catch (const std::exception &e) {
+    qCritical() << e.what();
+  } catch (...) {
+    qCritical() << "Unknown Exception";
+  }
+
+  std::abort();
+}
+
+/**
+ * @brief main function
+ */
+int main(int argc, char *argv[]) {
+  // using some classes from namespace
+  using srilakshmikanthanp::pulldog::constants::getAppHome;
+  using srilakshmikanthanp::pulldog::constants::getAppName;
+  using srilakshmikanthanp::pulldog::constants::getAppVersion;
+  using srilakshmikanthanp::pulldog::PullDogDaemon;
+  using srilakshmikanthanp::pulldog::logging::Logger;
+
+  PullDogDaemon app(argc, argv);
+
+  // set the application version
+  app.setApplicationVersion(getAppVersion());
+
+  // parser for the flags
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("Headless pulldog, copies the watched folders without a ui");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addOptions({
+    {{"c", "config"}, "Read the settings from the ini <file>.", "file"},
+    {{"d", "dest"}, "Copy to the destination <root>.", "root"},
+    {{"w", "watch"}, "Watch the <folder>, repeat for more.", "folder"},
+    {"bandwidth", "Limit the copies to <bytes> per second.", "bytes"},
+    {"quiet", "Copy a file once unchanged for <ms>.", "ms"},
+    {"drain-timeout", "Wait <seconds> for the transfers on termination.", "seconds"},
+    {"metrics", "Serve Prometheus metrics on unix:<path>, <host>:<port> or <port> of the loopback.", "address"},
+  });
+
+  // parse the flags
+  parser.process(app);
+
+  // logs go to the stderr for the service manager
+  QTextStream logstream(stderr);
+
+  // Set the log file as std::cerr
+  Logger::setLogStream(&logstream);
+
+  // Set the custom message handler
+  qInstallMessageHandler(Logger::handler);
+
+  // Set the global error handler
+  std::set_terminate(globalErrorHandler);
+
+  // Home Directory of the application
+  auto path = QString::fromStdString(getAppHome());
+
+  // make app home directory if not exists
+  if (!QDir(path).exists() && !QDir().mkdir(path)) {
+    qCritical() << "Can't Create App Home";
+    return EXIT_FAILURE;
+  }
+
+  // one daemon at a time owns the journal
+  QLockFile lock(QDir(path).filePath(QString("%1d.lock").arg(getAppName())));
+
+  if (!lock.tryLock()) {
+    qCritical() << "Another daemon is running";
+    return EXIT_FAILURE;
+  }
+
+  // start the controller
+  app.start(parser);
+
+  return app.exec();
+}
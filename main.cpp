@@ -15,6 +15,7 @@
 
 #include "constants/constants.hpp"
 #include "controller/controller.hpp"
+#include "ui/gui/utility/functions/functions.hpp"
 #include "ui/gui/window/pulldog/pulldog.hpp"
 #include "utility/logging/logging.hpp"
 
@@ -121,6 +122,64 @@ class PullDogApplication : public SingleApplication {
       controller->addWatchPath(path);
     }
 
+    // set bandwidth limits
+    controller->setBandwidthLimit(storage->getBandwidthLimit());
+    controller->setBandwidthSchedule(common::Governor::Window::listFromStrings(storage->getBandwidthSchedule()));
+
+    // set bandwidth limits of the watch paths
+    auto limits = storage->getWatchBandwidthLimits();
+    for (auto it = limits.cbegin(); it != limits.cend(); ++it) {
+      controller->setWatchBandwidthLimit(it.key(), it.value());
+    }
+
+    auto schedules = storage->getWatchBandwidthSchedules();
+    for (auto it = schedules.cbegin(); it != schedules.cend(); ++it) {
+      controller->setWatchBandwidthSchedule(it.key(), common::Governor::Window::listFromStrings(it.value()));
+    }
+
+    // dedup confirmation from the storage
+    const auto toConfirm = [](const QString &confirm) {
+      using Confirm = common::Dedup::Confirm;
+      return confirm == "sampled" ? Confirm::SAMPLED : Confirm::FULL;
+    };
+
+    // set dedup of identical files
+    controller->setDedupEnabled(storage->getDedupEnabled());
+    controller->setDedupConfirm(toConfirm(storage->getDedupConfirm()));
+
+    // scheduler rules from the storage
+    const auto toRules = [](const QStringList &list) {
+      QList<common::Scheduler::Rule> rules;
+      for (const auto &rule : list) {
+        rules.append(common::Scheduler::Rule::fromString(rule));
+      }
+      return rules;
+    };
+
+    // set scheduler rules
+    controller->setSchedulerRules(toRules(storage->getSchedulerRules()));
+
+    // set the quiet window of written files
+    controller->setQuietWindow(storage->getQuietWindow());
+
+    // set the mirrors of the watch roots
+    controller->setMirrors(storage->getMirrors());
+
+    // routes from the storage
+    const auto toRoutes = [](const QStringList &list) {
+      QList<common::Router::Route> routes;
+      for (const auto &route : list) {
+        routes.append(common::Router::Route::fromString(route));
+      }
+      return routes;
+    };
+
+    // set the routes of the files
+    controller->setRoutes(toRoutes(storage->getRoutes()));
+
+    // serve the metrics if asked for
+    controller->setMetricsAddress(storage->getMetricsAddress());
+
     // tray icon click from content
     QObject::connect(
       trayIcon, &QSystemTrayIcon::activated,
@@ -153,6 +212,72 @@ class PullDogApplication : public SingleApplication {
       controller, &Controller::setDestinationRoot
     );
 
+    // bandwidth limits are applied live
+    connect(
+      storage, &storage::Storage::onBandwidthLimitChanged,
+      controller, &Controller::setBandwidthLimit
+    );
+
+    connect(
+      storage, &storage::Storage::onBandwidthScheduleChanged,
+      [=](const QStringList &list) {
+        controller->setBandwidthSchedule(common::Governor::Window::listFromStrings(list));
+      }
+    );
+
+    connect(
+      storage, &storage::Storage::onWatchBandwidthLimitChanged,
+      controller, &Controller::setWatchBandwidthLimit
+    );
+
+    connect(
+      storage, &storage::Storage::onWatchBandwidthScheduleChanged,
+      [=](const QString &path, const QStringList &list) {
+        controller->setWatchBandwidthSchedule(path, common::Governor::Window::listFromStrings(list));
+      }
+    );
+
+    // dedup settings are applied live
+    connect(
+      storage, &storage::Storage::onDedupEnabledChanged,
+      controller, &Controller::setDedupEnabled
+    );
+
+    connect(
+      storage, &storage::Storage::onDedupConfirmChanged,
+      [=](const QString &confirm) { controller->setDedupConfirm(toConfirm(confirm)); }
+    );
+
+    // scheduler rules are applied live
+    connect(
+      storage, &storage::Storage::onSchedulerRulesChanged,
+      [=](const QStringList &list) { controller->setSchedulerRules(toRules(list)); }
+    );
+
+    // quiet window is applied live
+    connect(
+      storage, &storage::Storage::onQuietWindowChanged,
+      controller, &Controller::setQuietWindow
+    );
+
+    // mirrors are applied live
+    connect(
+      storage, &storage::Storage::onMirrorsChanged,
+      controller, &Controller::setMirrors
+    );
+
+    // routes are applied live
+    connect(
+      storage, &storage::Storage::onRoutesChanged,
+      [=](const QStringList &list) { controller->setRoutes(toRoutes(list)); }
+    );
+
+    // metrics address is applied live
+    connect(
+      storage, &storage::Storage::onMetricsAddressChanged,
+      controller, &Controller::setMetricsAddress
+    );
+
     // set watch list signal to controller
     connect(
       window, &PullDog::onFolderAddRequested,
@@ -267,7 +392,7 @@ class PullDogEventFilter : public QObject {
 
   void handleWindowShownEvent(QWidget *window) {
     if (!(window->windowFlags() & Qt::FramelessWindowHint)) {
-      utility::setPlatformAttributes(window);
+      ui::gui::utility::setPlatformAttributes(window);
     }
   }
 };
@@ -0,0 +1,20 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "stats.hpp"
+
+namespace srilakshmikanthanp::pulldog::models {
+/**
+ * @brief Human readable representation
+ */
+QString TransferStats::toString() const {
+  return QString("bytes=%1 elapsed=%2ms throttled=%3ms holes=%4 mode=%5")
+      .arg(bytes)
+      .arg(elapsed)
+      .arg(throttled)
+      .arg(holes)
+      .arg(mode);
+}
+}  // namespace srilakshmikanthanp::pulldog::models
@@ -0,0 +1,29 @@
+#pragma once  // Header guard see https://en.wikipedia.org/wiki/Include_guard
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QMetaType>
+#include <QString>
+
+namespace srilakshmikanthanp::pulldog::models {
+/**
+ * @brief Statistics of a single transfer reported by the copier
+ */
+struct TransferStats {
+  qint64 bytes     = 0;  // bytes moved over the wire
+  qint64 elapsed   = 0;  // milliseconds spent on the copy
+  qint64 throttled = 0;  // milliseconds waited on the bandwidth governor
+  qint64 holes     = 0;  // bytes of holes skipped by the sparse copy
+  QString mode;          // copy mode chosen by the copier
+
+  /**
+   * @brief Human readable representation
+   */
+  QString toString() const;
+};
+}  // namespace srilakshmikanthanp::pulldog::models
+
+Q_DECLARE_METATYPE(srilakshmikanthanp::pulldog::models::TransferStats)
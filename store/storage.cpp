@@ -15,6 +15,15 @@ Storage::Storage(QObject* parent) : QObject(parent) {
   this->settings->setParent(this);
 }
 
+/**
+ * @brief Read and write the settings from the ini file instead
+ * of the settings of the user
+ */
+void Storage::setFile(const QString& file) {
+  delete this->settings;
+  this->settings = new QSettings(file, QSettings::IniFormat, this);
+}
+
 /**
  * @brief Set the paths
  */
@@ -56,7 +65,7 @@ void Storage::addPath(const QString& path) {
 }
 
 /**
- * @brief Remove path from store
+ * @brief Remove path from store along with its bandwidth limits
  */
 void Storage::removePath(const QString& path) {
   this->settings->beginGroup(this->watchGroup);
@@ -64,6 +73,17 @@ void Storage::removePath(const QString& path) {
   paths.removeAll(path);
   this->settings->setValue(this->paths, paths);
   this->settings->endGroup();
+
+  // the limits go with the watch path
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto limits = this->settings->value(this->bandwidthRootLimits).toMap();
+  auto schedules = this->settings->value(this->bandwidthRootSchedules).toMap();
+  limits.remove(path);
+  schedules.remove(path);
+  this->settings->setValue(this->bandwidthRootLimits, limits);
+  this->settings->setValue(this->bandwidthRootSchedules, schedules);
+  this->settings->endGroup();
+
   emit onPathRemoved(path);
 }
 
@@ -93,6 +113,269 @@ void Storage::setDownloadPath(const QString& path) {
   emit onDownloadPathChanged(path);
 }
 
+/**
+ * @brief Get the Bandwidth Limit in bytes per second
+ */
+qint64 Storage::getBandwidthLimit() {
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto rate = this->settings->value(this->bandwidthLimit, 0).toLongLong();
+  this->settings->endGroup();
+  return rate;
+}
+
+/**
+ * @brief Set the Bandwidth Limit in bytes per second
+ */
+void Storage::setBandwidthLimit(qint64 rate) {
+  this->settings->beginGroup(this->bandwidthGroup);
+  this->settings->setValue(this->bandwidthLimit, rate);
+  this->settings->endGroup();
+  emit onBandwidthLimitChanged(rate);
+}
+
+/**
+ * @brief Get the Bandwidth Schedule as HH:mm-HH:mm=rate
+ */
+QStringList Storage::getBandwidthSchedule() {
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto schedule = this->settings->value(this->bandwidthSchedule).toStringList();
+  this->settings->endGroup();
+  return schedule;
+}
+
+/**
+ * @brief Set the Bandwidth Schedule as HH:mm-HH:mm=rate
+ */
+void Storage::setBandwidthSchedule(const QStringList& schedule) {
+  this->settings->beginGroup(this->bandwidthGroup);
+  this->settings->setValue(this->bandwidthSchedule, schedule);
+  this->settings->endGroup();
+  emit onBandwidthScheduleChanged(schedule);
+}
+
+/**
+ * @brief Get the Bandwidth Limits of the watch paths in bytes per second
+ */
+QMap<QString, qint64> Storage::getWatchBandwidthLimits() {
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto roots = this->settings->value(this->bandwidthRootLimits).toMap();
+  this->settings->endGroup();
+
+  QMap<QString, qint64> limits;
+
+  for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+    limits.insert(it.key(), it.value().toLongLong());
+  }
+
+  return limits;
+}
+
+/**
+ * @brief Set the Bandwidth Limit of the watch path, zero is unlimited
+ */
+void Storage::setWatchBandwidthLimit(const QString& path, qint64 rate) {
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto roots = this->settings->value(this->bandwidthRootLimits).toMap();
+
+  if (rate > 0) {
+    roots.insert(path, rate);
+  } else {
+    roots.remove(path);
+  }
+
+  this->settings->setValue(this->bandwidthRootLimits, roots);
+  this->settings->endGroup();
+  emit onWatchBandwidthLimitChanged(path, rate);
+}
+
+/**
+ * @brief Get the Bandwidth Schedules of the watch paths as HH:mm-HH:mm=rate
+ */
+QMap<QString, QStringList> Storage::getWatchBandwidthSchedules() {
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto roots = this->settings->value(this->bandwidthRootSchedules).toMap();
+  this->settings->endGroup();
+
+  QMap<QString, QStringList> schedules;
+
+  for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+    schedules.insert(it.key(), it.value().toStringList());
+  }
+
+  return schedules;
+}
+
+/**
+ * @brief Set the Bandwidth Schedule of the watch path as HH:mm-HH:mm=rate
+ */
+void Storage::setWatchBandwidthSchedule(const QString& path, const QStringList& schedule) {
+  this->settings->beginGroup(this->bandwidthGroup);
+  auto roots = this->settings->value(this->bandwidthRootSchedules).toMap();
+
+  if (schedule.isEmpty()) {
+    roots.remove(path);
+  } else {
+    roots.insert(path, schedule);
+  }
+
+  this->settings->setValue(this->bandwidthRootSchedules, roots);
+  this->settings->endGroup();
+  emit onWatchBandwidthScheduleChanged(path, schedule);
+}
+
+/**
+ * @brief is the dedup of identical files enabled
+ */
+bool Storage::getDedupEnabled() {
+  this->settings->beginGroup(this->dedupGroup);
+  auto enabled = this->settings->value(this->dedupEnabled, false).toBool();
+  this->settings->endGroup();
+  return enabled;
+}
+
+/**
+ * @brief Enable or disable the dedup of identical files
+ */
+void Storage::setDedupEnabled(bool enabled) {
+  this->settings->beginGroup(this->dedupGroup);
+  this->settings->setValue(this->dedupEnabled, enabled);
+  this->settings->endGroup();
+  emit onDedupEnabledChanged(enabled);
+}
+
+/**
+ * @brief Get how dedup candidates are confirmed, full or sampled
+ */
+QString Storage::getDedupConfirm() {
+  this->settings->beginGroup(this->dedupGroup);
+  auto confirm = this->settings->value(this->dedupConfirm, "full").toString();
+  this->settings->endGroup();
+  return confirm;
+}
+
+/**
+ * @brief Set how dedup candidates are confirmed, full or sampled
+ */
+void Storage::setDedupConfirm(const QString& confirm) {
+  this->settings->beginGroup(this->dedupGroup);
+  this->settings->setValue(this->dedupConfirm, confirm);
+  this->settings->endGroup();
+  emit onDedupConfirmChanged(confirm);
+}
+
+/**
+ * @brief Get the Scheduler Rules as class=N;path=P;ext=a,b;size=min-max
+ */
+QStringList Storage::getSchedulerRules() {
+  this->settings->beginGroup(this->schedulerGroup);
+  auto rules = this->settings->value(this->schedulerRules).toStringList();
+  this->settings->endGroup();
+  return rules;
+}
+
+/**
+ * @brief Set the Scheduler Rules as class=N;path=P;ext=a,b;size=min-max
+ */
+void Storage::setSchedulerRules(const QStringList& rules) {
+  this->settings->beginGroup(this->schedulerGroup);
+  this->settings->setValue(this->schedulerRules, rules);
+  this->settings->endGroup();
+  emit onSchedulerRulesChanged(rules);
+}
+
+/**
+ * @brief Get the quiet window of a file in milliseconds
+ */
+qint64 Storage::getQuietWindow() {
+  this->settings->beginGroup(this->readinessGroup);
+  auto window = this->settings->value(this->readinessQuiet, 2000).toLongLong();
+  this->settings->endGroup();
+  return window;
+}
+
+/**
+ * @brief Set the quiet window of a file in milliseconds
+ */
+void Storage::setQuietWindow(qint64 window) {
+  this->settings->beginGroup(this->readinessGroup);
+  this->settings->setValue(this->readinessQuiet, window);
+  this->settings->endGroup();
+  emit onQuietWindowChanged(window);
+}
+
+/**
+ * @brief Get the destination roots a watch root is mirrored to
+ */
+QMap<QString, QStringList> Storage::getMirrors() {
+  this->settings->beginGroup(this->mirrorGroup);
+  auto roots = this->settings->value(this->mirrorRoots).toMap();
+  this->settings->endGroup();
+
+  QMap<QString, QStringList> mirrors;
+
+  for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+    mirrors.insert(it.key(), it.value().toStringList());
+  }
+
+  return mirrors;
+}
+
+/**
+ * @brief Set the destination roots a watch root is mirrored to
+ */
+void Storage::setMirrors(const QMap<QString, QStringList>& mirrors) {
+  QVariantMap roots;
+
+  for (auto it = mirrors.cbegin(); it != mirrors.cend(); ++it) {
+    roots.insert(it.key(), it.value());
+  }
+
+  this->settings->beginGroup(this->mirrorGroup);
+  this->settings->setValue(this->mirrorRoots, roots);
+  this->settings->endGroup();
+  emit onMirrorsChanged(mirrors);
+}
+
+/**
+ * @brief Get the Routes as from=P;glob=G;to=T
+ */
+QStringList Storage::getRoutes() {
+  this->settings->beginGroup(this->routingGroup);
+  auto routes = this->settings->value(this->routingRoutes).toStringList();
+  this->settings->endGroup();
+  return routes;
+}
+
+/**
+ * @brief Set the Routes as from=P;glob=G;to=T
+ */
+void Storage::setRoutes(const QStringList& routes) {
+  this->settings->beginGroup(this->routingGroup);
+  this->settings->setValue(this->routingRoutes, routes);
+  this->settings->endGroup();
+  emit onRoutesChanged(routes);
+}
+
+/**
+ * @brief Get the address of the metrics, empty if not served
+ */
+QString Storage::getMetricsAddress() {
+  this->settings->beginGroup(this->metricsGroup);
+  auto address = this->settings->value(this->metricsAddress).toString();
+  this->settings->endGroup();
+  return address;
+}
+
+/**
+ * @brief Set the address of the metrics as unix:PATH, HOST:PORT or PORT
+ */
+void Storage::setMetricsAddress(const QString& address) {
+  this->settings->beginGroup(this->metricsGroup);
+  this->settings->setValue(this->metricsAddress, address);
+  this->settings->endGroup();
+  emit onMetricsAddressChanged(address);
+}
+
 /**
  * @brief Instance of the storage
  */
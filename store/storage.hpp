@@ -6,7 +6,10 @@
 // https://opensource.org/licenses/MIT
 
 #include <QObject>
+#include <QMap>
 #include <QSettings>
+#include <QStringList>
+#include <QVariantMap>
 
 #include "constants/constants.hpp"
 
@@ -19,15 +22,44 @@ class Storage : public QObject {
  private: // groups
   const QString downloadGroup = "download";
   const QString watchGroup  = "files";
+  const QString bandwidthGroup = "bandwidth";
+  const QString dedupGroup = "dedup";
+  const QString schedulerGroup = "scheduler";
+  const QString readinessGroup = "readiness";
+  const QString mirrorGroup = "mirror";
+  const QString routingGroup = "routing";
+  const QString metricsGroup = "metrics";
 
  private: // keys
   const QString downloadPath = "downloadPath";
   const QString paths = "paths";
+  const QString bandwidthLimit = "limit";
+  const QString bandwidthSchedule = "schedule";
+  const QString bandwidthRootLimits = "rootLimits";
+  const QString bandwidthRootSchedules = "rootSchedules";
+  const QString dedupEnabled = "enabled";
+  const QString dedupConfirm = "confirm";
+  const QString schedulerRules = "rules";
+  const QString readinessQuiet = "quiet";
+  const QString mirrorRoots = "roots";
+  const QString routingRoutes = "routes";
+  const QString metricsAddress = "address";
 
  signals:
   void onDownloadPathChanged(const QString& path);
   void onPathAdded(const QString& path);
   void onPathRemoved(const QString& path);
+  void onBandwidthLimitChanged(qint64 rate);
+  void onBandwidthScheduleChanged(const QStringList& schedule);
+  void onWatchBandwidthLimitChanged(const QString& path, qint64 rate);
+  void onWatchBandwidthScheduleChanged(const QString& path, const QStringList& schedule);
+  void onDedupEnabledChanged(bool enabled);
+  void onDedupConfirmChanged(const QString& confirm);
+  void onSchedulerRulesChanged(const QStringList& rules);
+  void onQuietWindowChanged(qint64 window);
+  void onMirrorsChanged(const QMap<QString, QStringList>& mirrors);
+  void onRoutesChanged(const QStringList& routes);
+  void onMetricsAddressChanged(const QString& address);
 
  private:  // qt
 
@@ -51,6 +83,12 @@ class Storage : public QObject {
    */
   virtual ~Storage() = default;
 
+  /**
+   * @brief Read and write the settings from the ini file instead
+   * of the settings of the user
+   */
+  void setFile(const QString& file);
+
   /**
    * @brief Set the paths
    */
@@ -72,7 +110,7 @@ class Storage : public QObject {
   void addPath(const QString& path);
 
   /**
-   * @brief Remove path from store
+   * @brief Remove path from store along with its bandwidth limits
    */
   void removePath(const QString& path);
 
@@ -86,6 +124,116 @@ class Storage : public QObject {
    */
   void setDownloadPath(const QString& path);
 
+  /**
+   * @brief Get the Bandwidth Limit in bytes per second
+   */
+  qint64 getBandwidthLimit();
+
+  /**
+   * @brief Set the Bandwidth Limit in bytes per second
+   */
+  void setBandwidthLimit(qint64 rate);
+
+  /**
+   * @brief Get the Bandwidth Schedule as HH:mm-HH:mm=rate
+   */
+  QStringList getBandwidthSchedule();
+
+  /**
+   * @brief Set the Bandwidth Schedule as HH:mm-HH:mm=rate
+   */
+  void setBandwidthSchedule(const QStringList& schedule);
+
+  /**
+   * @brief Get the Bandwidth Limits of the watch paths in bytes per second
+   */
+  QMap<QString, qint64> getWatchBandwidthLimits();
+
+  /**
+   * @brief Set the Bandwidth Limit of the watch path, zero is unlimited
+   */
+  void setWatchBandwidthLimit(const QString& path, qint64 rate);
+
+  /**
+   * @brief Get the Bandwidth Schedules of the watch paths as HH:mm-HH:mm=rate
+   */
+  QMap<QString, QStringList> getWatchBandwidthSchedules();
+
+  /**
+   * @brief Set the Bandwidth Schedule of the watch path as HH:mm-HH:mm=rate
+   */
+  void setWatchBandwidthSchedule(const QString& path, const QStringList& schedule);
+
+  /**
+   * @brief is the dedup of identical files enabled
+   */
+  bool getDedupEnabled();
+
+  /**
+   * @brief Enable or disable the dedup of identical files
+   */
+  void setDedupEnabled(bool enabled);
+
+  /**
+   * @brief Get how dedup candidates are confirmed, full or sampled
+   */
+  QString getDedupConfirm();
+
+  /**
+   * @brief Set how dedup candidates are confirmed, full or sampled
+   */
+  void setDedupConfirm(const QString& confirm);
+
+  /**
+   * @brief Get the Scheduler Rules as class=N;path=P;ext=a,b;size=min-max
+   */
+  QStringList getSchedulerRules();
+
+  /**
+   * @brief Set the Scheduler Rules as class=N;path=P;ext=a,b;size=min-max
+   */
+  void setSchedulerRules(const QStringList& rules);
+
+  /**
+   * @brief Get the quiet window of a file in milliseconds
+   */
+  qint64 getQuietWindow();
+
+  /**
+   * @brief Set the quiet window of a file in milliseconds
+   */
+  void setQuietWindow(qint64 window);
+
+  /**
+   * @brief Get the destination roots a watch root is mirrored to
+   */
+  QMap<QString, QStringList> getMirrors();
+
+  /**
+   * @brief Set the destination roots a watch root is mirrored to
+   */
+  void setMirrors(const QMap<QString, QStringList>& mirrors);
+
+  /**
+   * @brief Get the Routes as from=P;glob=G;to=T
+   */
+  QStringList getRoutes();
+
+  /**
+   * @brief Set the Routes as from=P;glob=G;to=T
+   */
+  void setRoutes(const QStringList& routes);
+
+  /**
+   * @brief Get the address of the metrics, empty if not served
+   */
+  QString getMetricsAddress();
+
+  /**
+   * @brief Set the address of the metrics as unix:PATH, HOST:PORT or PORT
+   */
+  void setMetricsAddress(const QString& address);
+
   /**
    * @brief Instance of the storage
    */
@@ -0,0 +1,187 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QFile>
+#include <QList>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "common/checkpoint/checkpoint.hpp"
+
+using srilakshmikanthanp::pulldog::common::Checkpoint;
+
+/**
+ * @brief Tests of the checkpoint journal of a staged copy, what it
+ * keeps across a save and when a part file is resumed
+ */
+class TestCheckpoint : public QObject {
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ private:
+
+  using Range = Checkpoint::Range;
+
+  QTemporaryDir dir;
+
+ private:
+
+  /**
+   * @brief Identity of a source version
+   */
+  static Checkpoint::Identity identityOf(qint64 size, qint64 mtime) {
+    Checkpoint::Identity identity;
+    identity.size   = size;
+    identity.mtime  = mtime;
+    identity.device = 42;
+    identity.inode  = 7;
+    return identity;
+  }
+
+  /**
+   * @brief Path of a file in the temporary directory
+   */
+  QString pathOf(const QString &name) const {
+    return dir.filePath(name);
+  }
+
+  /**
+   * @brief Create a part file
+   */
+  void touch(const QString &path) {
+    QFile part(path);
+    QVERIFY(part.open(QIODevice::WriteOnly));
+    QVERIFY(part.write(QByteArray(16, 'x')) == 16);
+  }
+
+ private slots:
+
+  /**
+   * @brief Overlapping and adjacent ranges merge into one sorted
+   * list and the gaps are what is left to copy
+   */
+  void mergesRanges() {
+    Checkpoint checkpoint(pathOf("merge.pulldog-journal"));
+    checkpoint.reset(identityOf(100, 1));
+
+    checkpoint.commit(40, 50);
+    checkpoint.commit(0, 10);
+    checkpoint.commit(10, 20);  // adjacent
+    checkpoint.commit(45, 60);  // overlapping
+    checkpoint.commit(80, 80);  // empty
+
+    QCOMPARE(checkpoint.getRanges(), (QList<Range>{{0, 20}, {40, 60}}));
+    QCOMPARE(checkpoint.missing(100), (QList<Range>{{20, 40}, {60, 100}}));
+    QCOMPARE(checkpoint.committed(), 40);
+
+    checkpoint.commit(15, 45);  // bridges both
+
+    QCOMPARE(checkpoint.getRanges(), (QList<Range>{{0, 60}}));
+    QCOMPARE(checkpoint.missing(100), (QList<Range>{{60, 100}}));
+    QVERIFY(checkpoint.missing(60).isEmpty());
+  }
+
+  /**
+   * @brief The identity and the ranges come back from disk
+   */
+  void savesAndLoads() {
+    auto file     = pathOf("load.pulldog-journal");
+    auto identity = identityOf(100, 2);
+
+    Checkpoint saved(file);
+    saved.reset(identity);
+    saved.commit(0, 30);
+    saved.commit(50, 70);
+    QVERIFY(saved.save());
+
+    Checkpoint loaded(file);
+    QVERIFY(loaded.load());
+    QVERIFY(loaded.getIdentity() == identity);
+    QCOMPARE(loaded.getRanges(), saved.getRanges());
+    QCOMPARE(loaded.missing(100), (QList<Range>{{30, 50}, {70, 100}}));
+  }
+
+  /**
+   * @brief A journal whose checksum doesn't match isn't loaded
+   */
+  void corruptChecksum() {
+    auto file = pathOf("corrupt.pulldog-journal");
+
+    Checkpoint saved(file);
+    saved.reset(identityOf(100, 3));
+    saved.commit(0, 50);
+    QVERIFY(saved.save());
+
+    QFile journal(file);
+    QVERIFY(journal.open(QIODevice::ReadWrite));
+    auto data = journal.readAll();
+    data[data.size() / 2] = static_cast<char>(data[data.size() / 2] ^ 0xff);
+    QVERIFY(journal.seek(0));
+    QVERIFY(journal.write(data) == data.size());
+    journal.close();
+
+    Checkpoint loaded(file);
+    QVERIFY(!loaded.load());
+    QVERIFY(loaded.getRanges().isEmpty());
+  }
+
+  /**
+   * @brief The part file is resumed from its ranges while the
+   * source is the version it was copied from
+   */
+  void resumesSameSource() {
+    auto file     = pathOf("same.pulldog-journal");
+    auto part     = pathOf("same.pulldog-part");
+    auto identity = identityOf(100, 4);
+
+    Checkpoint saved(file);
+    saved.reset(identity);
+    saved.commit(0, 60);
+    QVERIFY(saved.save());
+    touch(part);
+
+    Checkpoint checkpoint(file);
+    QVERIFY(checkpoint.resume(identity, part));
+    QCOMPARE(checkpoint.missing(identity.size), (QList<Range>{{60, 100}}));
+  }
+
+  /**
+   * @brief The part file of an other version of the source, or a
+   * journal without its part file, is copied over from the start
+   */
+  void restartsChangedSource() {
+    auto file     = pathOf("changed.pulldog-journal");
+    auto part     = pathOf("changed.pulldog-part");
+    auto identity = identityOf(100, 5);
+
+    Checkpoint saved(file);
+    saved.reset(identity);
+    saved.commit(0, 60);
+    QVERIFY(saved.save());
+
+    // the part file went away
+    Checkpoint missing(file);
+    QVERIFY(!missing.resume(identity, part));
+
+    touch(part);
+
+    // the source was rewritten or replaced
+    auto rewritten = identityOf(100, 6);
+    auto replaced  = identity;
+    replaced.inode = 8;
+
+    Checkpoint changed(file);
+    QVERIFY(!changed.resume(rewritten, part));
+    QVERIFY(!changed.resume(replaced, part));
+
+    changed.reset(rewritten);
+    QCOMPARE(changed.missing(rewritten.size), (QList<Range>{{0, 100}}));
+  }
+};
+
+QTEST_APPLESS_MAIN(TestCheckpoint)
+
+#include "tst_checkpoint.moc"
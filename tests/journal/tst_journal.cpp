@@ -0,0 +1,216 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <utility>
+
+#include "common/journal/journal.hpp"
+#include "constants/constants.hpp"
+#include "models/transfer/transfer.hpp"
+
+using srilakshmikanthanp::pulldog::common::Journal;
+using srilakshmikanthanp::pulldog::models::Transfer;
+namespace constants = srilakshmikanthanp::pulldog::constants;
+
+/**
+ * @brief Tests of the replay of a journal whose tail was torn or
+ * corrupted, the journal is read once per process so ctest runs every
+ * case in a process of its own
+ */
+class TestJournal : public QObject {
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ private:
+  static inline const quint32 magic   = 0x5044544A;
+  static inline const quint16 version = 1;
+
+ private:
+  QTemporaryDir home;
+  bool replayed = false;
+
+ private:
+
+  /**
+   * @brief Header of the journal
+   */
+  static QByteArray header() {
+    QByteArray data;
+    QDataStream(&data, QIODevice::WriteOnly) << magic << version;
+    return data;
+  }
+
+  /**
+   * @brief Payload of a record
+   */
+  static QByteArray payloadOf(Journal::State state, const Transfer &transfer, qint32 error) {
+    QByteArray payload;
+    QDataStream(&payload, QIODevice::WriteOnly)
+      << static_cast<quint8>(state) << transfer.getFrom() << transfer.getTo() << error;
+    return payload;
+  }
+
+  /**
+   * @brief Record as its length, the payload and the checksum
+   */
+  static QByteArray recordOf(Journal::State state, const Transfer &transfer, qint32 error = 0) {
+    auto payload = payloadOf(state, transfer, error);
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << static_cast<quint32>(payload.size());
+    stream.writeRawData(payload.constData(), payload.size());
+    stream << qChecksum(payload);
+
+    return data;
+  }
+
+  /**
+   * @brief Write the journal and replay it, false if this process
+   * already replayed one
+   */
+  bool replay(const QByteArray &data) {
+    if (std::exchange(replayed, true)) {
+      return false;
+    }
+
+    qputenv("HOME", QFile::encodeName(home.path()));
+
+    auto dir = QString::fromStdString(constants::getAppHome());
+    QDir().mkpath(dir);
+
+    QFile file(QDir(dir).filePath("transfers.journal"));
+
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+      return false;
+    }
+
+    file.close();
+    Journal::instance();
+
+    return true;
+  }
+
+  /**
+   * @brief Journal on disk after the replay
+   */
+  static QByteArray onDisk() {
+    QFile file(QDir(QString::fromStdString(constants::getAppHome())).filePath("transfers.journal"));
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+  }
+
+ private slots:
+
+  /**
+   * @brief A length beyond the end of the file ends the replay and the
+   * compaction truncates it away
+   */
+  void tornLength() {
+    Transfer a("/src/a", "/dst/a"), b("/src/b", "/dst/b");
+
+    QByteArray data = header();
+    data += recordOf(Journal::State::QUEUED, a);
+    data += recordOf(Journal::State::QUEUED, b);
+    data += recordOf(Journal::State::COMMITTED, b);
+
+    QByteArray torn;
+    QDataStream(&torn, QIODevice::WriteOnly) << quint32(0x7FFFFFFF);
+    data += torn + "torn";
+
+    if (!replay(data)) {
+      QSKIP("the journal was already replayed in this process");
+    }
+
+    auto pending = Journal::instance().pending();
+    QCOMPARE(pending.size(), 1);
+    QVERIFY(pending.first() == a);
+    QCOMPARE(onDisk(), header() + recordOf(Journal::State::QUEUED, a));
+  }
+
+  /**
+   * @brief A record that fails its checksum ends the replay, nothing
+   * after it is trusted even if it looks whole
+   */
+  void corruptChecksum() {
+    Transfer a("/src/a", "/dst/a"), b("/src/b", "/dst/b"), c("/src/c", "/dst/c");
+
+    auto corrupt = recordOf(Journal::State::QUEUED, b);
+    corrupt[corrupt.size() - 1] = corrupt[corrupt.size() - 1] ^ 0x5A;
+
+    QByteArray data = header();
+    data += recordOf(Journal::State::QUEUED, a);
+    data += corrupt;
+    data += recordOf(Journal::State::QUEUED, c);
+
+    if (!replay(data)) {
+      QSKIP("the journal was already replayed in this process");
+    }
+
+    auto pending = Journal::instance().pending();
+    QCOMPARE(pending.size(), 1);
+    QVERIFY(pending.first() == a);
+  }
+
+  /**
+   * @brief A record cut short in its payload ends the replay
+   */
+  void cutShort() {
+    Transfer a("/src/a", "/dst/a"), b("/src/b", "/dst/b");
+
+    auto cut = recordOf(Journal::State::QUEUED, b);
+
+    QByteArray data = header();
+    data += recordOf(Journal::State::QUEUED, a);
+    data += cut.left(cut.size() / 2);
+
+    if (!replay(data)) {
+      QSKIP("the journal was already replayed in this process");
+    }
+
+    auto pending = Journal::instance().pending();
+    QCOMPARE(pending.size(), 1);
+    QVERIFY(pending.first() == a);
+  }
+
+  /**
+   * @brief A failed transfer survives the replay and a skipped one is
+   * forgotten like a committed one
+   */
+  void terminalStates() {
+    Transfer a("/src/a", "/dst/a"), b("/src/b", "/dst/b"), c("/src/c", "/dst/c");
+
+    QByteArray data = header();
+    data += recordOf(Journal::State::QUEUED, a);
+    data += recordOf(Journal::State::STARTED, a);
+    data += recordOf(Journal::State::QUEUED, b);
+    data += recordOf(Journal::State::SKIPPED, b);
+    data += recordOf(Journal::State::QUEUED, c);
+    data += recordOf(Journal::State::FAILED, c, 5);
+
+    if (!replay(data)) {
+      QSKIP("the journal was already replayed in this process");
+    }
+
+    auto pending = Journal::instance().pending();
+    QCOMPARE(pending.size(), 1);
+    QVERIFY(pending.first() == a);
+
+    auto failures = Journal::instance().failures();
+    QCOMPARE(failures.size(), 1);
+    QVERIFY(failures.first().first == c);
+    QCOMPARE(failures.first().second, 5);
+  }
+};
+
+QTEST_APPLESS_MAIN(TestJournal)
+
+#include "tst_journal.moc"
@@ -0,0 +1,134 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QList>
+#include <QTest>
+#include <QThread>
+
+#include <memory>
+
+#include "common/ring/ring.hpp"
+
+using srilakshmikanthanp::pulldog::common::Ring;
+
+/**
+ * @brief Tests of the ring the events go through, mostly what
+ * happens once it is full
+ */
+class TestRing : public QObject {
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ private slots:
+
+  /**
+   * @brief A full ring refuses the record and takes it again once
+   * the consumer made room
+   */
+  void refusesWhenFull() {
+    Ring<int, 4> ring;
+
+    for (int i = 0; i < 4; ++i) {
+      QVERIFY(ring.push(i));
+    }
+
+    QVERIFY(!ring.push(4));
+
+    int value = -1;
+    QVERIFY(ring.pop(value));
+    QCOMPARE(value, 0);
+
+    QVERIFY(ring.push(4));
+    QVERIFY(!ring.push(5));
+  }
+
+  /**
+   * @brief The records come out in the order they went in across
+   * many wraps of a full ring
+   */
+  void keepsOrderAcrossWraps() {
+    Ring<int, 4> ring;
+    int next = 0, expected = 0, value = -1;
+
+    for (int round = 0; round < 100; ++round) {
+      while (ring.push(next)) {
+        next++;
+      }
+
+      QVERIFY(ring.pop(value));
+      QCOMPARE(value, expected++);
+    }
+
+    while (ring.pop(value)) {
+      QCOMPARE(value, expected++);
+    }
+
+    QCOMPARE(expected, next);
+    QVERIFY(ring.isEmpty());
+  }
+
+  /**
+   * @brief An empty ring has nothing to pop
+   */
+  void emptyPopFails() {
+    Ring<int, 2> ring;
+    int value = -1;
+
+    QVERIFY(ring.isEmpty());
+    QVERIFY(!ring.pop(value));
+    QCOMPARE(value, -1);
+  }
+
+  /**
+   * @brief Producers that retry on a full ring lose nothing and the
+   * records of a producer stay in its order
+   */
+  void producersRetryOnFull() {
+    static const int producers = 4;
+    static const quint64 count = 20000;
+
+    Ring<quint64, 8> ring;
+    QList<QThread *> threads;
+
+    for (quint64 p = 0; p < producers; ++p) {
+      threads.append(QThread::create([&ring, p] {
+        for (quint64 i = 0; i < count; ++i) {
+          while (!ring.push(p << 32 | i)) {
+            QThread::yieldCurrentThread();
+          }
+        }
+      }));
+
+      threads.last()->start();
+    }
+
+    QList<quint64> seen(producers, 0);
+    quint64 received = 0, value = 0;
+
+    while (received < producers * count) {
+      if (!ring.pop(value)) {
+        QThread::yieldCurrentThread();
+        continue;
+      }
+
+      auto producer = value >> 32;
+      QVERIFY(producer < producers);
+      QCOMPARE(value & 0xFFFFFFFF, seen[producer]++);
+      received++;
+    }
+
+    for (auto thread : threads) {
+      thread->wait();
+      delete thread;
+    }
+
+    QVERIFY(ring.isEmpty());
+  }
+};
+
+QTEST_APPLESS_MAIN(TestRing)
+
+#include "tst_ring.moc"
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QList>
+#include <QTest>
+
+#include "common/router/router.hpp"
+
+using srilakshmikanthanp::pulldog::common::Router;
+
+/**
+ * @brief Tests of which route wins for a file
+ */
+class TestRouter : public QObject {
+ private:  // Just for qt
+
+  Q_OBJECT
+
+ private:
+
+  /**
+   * @brief Routes parsed from their text
+   */
+  static QList<Router::Route> routesOf(const QStringList &list) {
+    QList<Router::Route> routes;
+
+    for (const auto &route : list) {
+      routes.append(Router::Route::fromString(route));
+    }
+
+    return routes;
+  }
+
+ private slots:
+
+  /**
+   * @brief The route of the deepest prefix wins over a shallower one
+   * whatever their order, the path below the prefix is kept
+   */
+  void deepestPrefixWins() {
+    Router router;
+    router.setRoutes(routesOf({
+      "from=/src;glob=*.txt;to=/a",
+      "from=/src/docs;to=/b",
+    }));
+
+    QCOMPARE(router.resolve("/src/docs/x.txt").value_or(QString()), QString("/b/x.txt"));
+    QCOMPARE(router.resolve("/src/notes/y.txt").value_or(QString()), QString("/a/notes/y.txt"));
+    QCOMPARE(router.resolve("/src/docs/deep/z.bin").value_or(QString()), QString("/b/deep/z.bin"));
+  }
+
+  /**
+   * @brief Of the routes of the same prefix the earlier one wins,
+   * a suffix glob doesn't jump the queue
+   */
+  void earlierRouteWinsAtSamePrefix() {
+    Router router;
+
+    router.setRoutes(routesOf({"from=/src;glob=*.txt;to=/a", "from=/src;to=/c"}));
+    QCOMPARE(router.resolve("/src/y.txt").value_or(QString()), QString("/a/y.txt"));
+    QCOMPARE(router.resolve("/src/y.bin").value_or(QString()), QString("/c/y.bin"));
+
+    router.setRoutes(routesOf({"from=/src;to=/c", "from=/src;glob=*.txt;to=/a"}));
+    QCOMPARE(router.resolve("/src/y.txt").value_or(QString()), QString("/c/y.txt"));
+  }
+
+  /**
+   * @brief A suffix glob matches any case and every dotted tail
+   */
+  void suffixGlobMatchesTails() {
+    Router router;
+    router.setRoutes(routesOf({"from=/src;glob=*.tar.gz;to=/t", "from=/src;glob=*.TXT;to=/a"}));
+
+    QCOMPARE(router.resolve("/src/Y.txt").value_or(QString()), QString("/a/Y.txt"));
+    QCOMPARE(router.resolve("/src/b.1.tar.gz").value_or(QString()), QString("/t/b.1.tar.gz"));
+    QVERIFY(!router.resolve("/src/b.gz"));
+  }
+
+  /**
+   * @brief A glob with a slash matches the path below the prefix
+   */
+  void pathGlobMatchesBelowPrefix() {
+    Router router;
+    router.setRoutes(routesOf({"from=/src;glob=logs/*.log;to=/l"}));
+
+    QCOMPARE(router.resolve("/src/logs/a.log").value_or(QString()), QString("/l/logs/a.log"));
+    QVERIFY(!router.resolve("/src/a.log"));
+  }
+
+  /**
+   * @brief A file no route matches has no destination
+   */
+  void unmatchedHasNone() {
+    Router router;
+    router.setRoutes(routesOf({"from=/src;glob=*.txt;to=/a"}));
+
+    QVERIFY(!router.resolve("/other/y.txt"));
+    QVERIFY(!router.resolve("/src/y.bin"));
+  }
+};
+
+QTEST_APPLESS_MAIN(TestRouter)
+
+#include "tst_router.moc"
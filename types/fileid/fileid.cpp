@@ -31,9 +31,7 @@ void FileId::setFile(QString file) {
  * @brief is same file
  */
 bool FileId::isSameFile(const FileId &file) const {
-#ifdef _WIN32
   return high == file.high && low == file.low;
-#endif
 }
 
 /**
@@ -42,4 +40,11 @@ bool FileId::isSameFile(const FileId &file) const {
 bool FileId::operator==(const FileId &other) const {
   return this->isSameFile(other);
 }
+
+/**
+ * @brief Hash of the file id
+ */
+size_t qHash(const FileId &id, size_t seed) {
+  return qHashMulti(seed, id.high, id.low);
+}
 }  // namespace srilakshmikanthanp::pulldog::types
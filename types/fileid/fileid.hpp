@@ -9,6 +9,8 @@
 #include <windows.h>
 #endif
 
+#include <QHashFunctions>
+
 #include "utility/functions/functions.hpp"
 
 namespace srilakshmikanthanp::pulldog::types {
@@ -17,6 +19,8 @@ struct FileId {
 
 #ifdef _WIN32
   DWORD high, low;
+#else
+  quint64 high, low;  // device and inode
 #endif
 
  public:
@@ -45,5 +49,15 @@ struct FileId {
    * @brief Equality operator
    */
   bool operator==(const FileId &other) const;
+
+  /**
+   * @brief Hash of the file id
+   */
+  friend size_t qHash(const FileId &id, size_t seed);
 };
+
+/**
+ * @brief Hash of the file id
+ */
+size_t qHash(const FileId &id, size_t seed = 0);
 }  // namespace srilakshmikanthanp::pulldog::types
@@ -0,0 +1,27 @@
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "functions.hpp"
+
+namespace srilakshmikanthanp::pulldog::ui::gui::utility {
+/**
+ * @brief Function used to set the Os level attributes for the widget
+ */
+void setPlatformAttributes(QWidget *widget) {
+#ifdef _WIN32 // if it it windows platform set title bar to preferred theme
+  // cast the winId to HWND
+  BOOL isDark = QGuiApplication::styleHints()->colorScheme() == Qt::ColorScheme::Dark;
+  HWND hwnd = reinterpret_cast<HWND>(widget->winId());
+
+  // set the title bar to preferred theme
+  auto result = DwmSetWindowAttribute(
+    hwnd,
+    DWMWINDOWATTRIBUTE::DWMWA_USE_IMMERSIVE_DARK_MODE,
+    &isDark,
+    sizeof(isDark)
+  );
+#endif
+}
+}  // namespace srilakshmikanthanp::pulldog::ui::gui::utility
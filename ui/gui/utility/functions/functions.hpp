@@ -0,0 +1,24 @@
+#pragma once  // Header guard see https://en.wikipedia.org/wiki/Include_guard
+
+// Copyright (c) 2024 Sri Lakshmi Kanthan P
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <QGuiApplication>
+#include <QStyleHints>
+#include <QWidget>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <dwmapi.h>
+#undef NOMINMAX
+#endif
+
+namespace srilakshmikanthanp::pulldog::ui::gui::utility {
+/**
+ * @brief Function used to set the Os level attributes for the widget
+ */
+void setPlatformAttributes(QWidget *widget);
+}  // namespace srilakshmikanthanp::pulldog::ui::gui::utility
@@ -154,29 +154,11 @@ QString getFileNameFromHandle(HANDLE hFile) {
 }
 #endif
 
-/**
- * @brief Function used to set the Os level attributes for the widget
- */
-void setPlatformAttributes(QWidget *widget) {
-#ifdef _WIN32 // if it it windows platform set title bar to preferred theme
-  // cast the winId to HWND
-  BOOL isDark = QGuiApplication::styleHints()->colorScheme() == Qt::ColorScheme::Dark;
-  HWND hwnd = reinterpret_cast<HWND>(widget->winId());
-
-  // set the title bar to preferred theme
-  auto result = DwmSetWindowAttribute(
-    hwnd,
-    DWMWINDOWATTRIBUTE::DWMWA_USE_IMMERSIVE_DARK_MODE,
-    &isDark,
-    sizeof(isDark)
-  );
-#endif
-}
-
 /**
  * @brief Function used to chech the two file are same or not
  * using file id on windows
  */
+#ifdef _WIN32
 QPair<DWORD, DWORD> getFileId(QString file) {
   // get the file handle
   auto handle = CreateFile(
@@ -210,4 +192,17 @@ QPair<DWORD, DWORD> getFileId(QString file) {
   // return the file id
   return {info.nFileIndexHigh, info.nFileIndexLow};
 }
+#else
+QPair<quint64, quint64> getFileId(QString file) {
+  struct stat info;
+
+  // get the device and inode of the file
+  if (::stat(QFile::encodeName(file).constData(), &info) != 0) {
+    throw std::runtime_error("Failed to get file id: " + std::to_string(errno));
+  }
+
+  // return the file id
+  return {static_cast<quint64>(info.st_dev), static_cast<quint64>(info.st_ino)};
+}
+#endif
 }  // namespace srilakshmikanthanp::utility
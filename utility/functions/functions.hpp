@@ -5,11 +5,6 @@
 // This software is released under the MIT License.
 // https://opensource.org/licenses/MIT
 
-#include <QStyleHints>
-#include <QGuiApplication>
-#include <QStyleHints>
-#include <QWidget>
-#include <QWidget>
 #include <QFile>
 #include <QString>
 #include <QFileInfo>
@@ -18,8 +13,10 @@
 #ifdef _WIN32
 #define NOMINMAX
 #include <windows.h>
-#include <dwmapi.h>
 #undef NOMINMAX
+#else
+#include <sys/stat.h>
+#include <cerrno>
 #endif
 
 #include <random>
@@ -49,13 +46,12 @@ bool isUptoDate(const QString &src, const QString &dest);
 QString getFileNameFromHandle(HANDLE hFile);
 #endif
 
-/**
- * @brief Function used to set the Os level attributes for the widget
- */
-void setPlatformAttributes(QWidget *widget);
-
 /**
  * @brief Function used to get the file id
  */
+#ifdef _WIN32
 QPair<DWORD, DWORD> getFileId(QString file);
+#else
+QPair<quint64, quint64> getFileId(QString file);
+#endif
 }  // namespace srilakshmikanthanp::utility